@@ -0,0 +1,216 @@
+// Engine microbenchmarks; prints one JSON document to stdout
+// usage: maze_bench [--seeds N] [--max-rounds R] [--min-ms M]
+#include "game.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+// Allocation counting via the linker's --wrap (see Makefile bench target)
+static atomic_ullong allocCount;
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t sz);
+void* __real_realloc(void* p, size_t n);
+void* __wrap_malloc(size_t n){ atomic_fetch_add(&allocCount,1); return __real_malloc(n); }
+void* __wrap_calloc(size_t n, size_t sz){ atomic_fetch_add(&allocCount,1); return __real_calloc(n,sz); }
+void* __wrap_realloc(void* p, size_t n){ atomic_fetch_add(&allocCount,1); return __real_realloc(p,n); }
+
+static volatile int benchSink; // keeps results observable
+
+static double now_ns(void){
+    struct timespec ts; timespec_get(&ts,TIME_UTC);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+typedef struct {
+    unsigned seeds;
+    int maxRounds;
+    double minMs; // each benchmark repeats until at least this long
+} BenchOptions;
+
+typedef struct {
+    const char* name;
+    unsigned long long ops;
+    double ns;
+    unsigned long long allocs;
+} BenchResult;
+
+typedef struct {
+    const BenchOptions* opt;
+    Board* boards; // one per seed
+    Game* games;   // fresh game per seed; 3 players, so clones into the static Games below never allocate
+} BenchCtx;
+
+// Runs fn(ctx, i) for i=0.. until minMs elapsed; fn returns the number of ops it performed
+typedef unsigned long long (*BenchFn)(BenchCtx* ctx, unsigned long long i);
+
+static BenchResult run_bench(const char* name, BenchCtx* ctx, BenchFn fn){
+    BenchResult r = { name, 0, 0.0, 0 };
+    unsigned long long a0 = atomic_load(&allocCount);
+    double t0 = now_ns(), limit = ctx->opt->minMs*1e6;
+    unsigned long long i=0;
+    do {
+        for(int k=0;k<64;++k,++i) r.ops += fn(ctx,i);
+        r.ns = now_ns()-t0;
+    } while(r.ns < limit);
+    r.allocs = atomic_load(&allocCount)-a0;
+    return r;
+}
+
+static unsigned bench_seed(const BenchCtx* ctx, unsigned long long i){ return 1u + (unsigned)(i % ctx->opt->seeds); }
+
+static unsigned long long b_maze_init(BenchCtx* ctx, unsigned long long i){
+    static Maze m;
+    maze_init(&m,bench_seed(ctx,i)); benchSink += m.flagX; return 1;
+}
+
+static unsigned long long b_board_init(BenchCtx* ctx, unsigned long long i){
+    static Board b;
+    board_init(&b,bench_seed(ctx,i)); benchSink += b.maze.flagY; return 1;
+}
+
+static unsigned long long b_game_init(BenchCtx* ctx, unsigned long long i){
+    unsigned k = bench_seed(ctx,i)-1;
+    static Game g; game_init_from_board(&g,&ctx->boards[k],k+1); benchSink += (int)g.rng.s[0]; return 1;
+}
+
+// Turns on a game that is restarted every 64 rounds so the state mix stays early-game
+static void take_turn_on(BenchCtx* ctx, unsigned long long i, Game* g, int* player, bool generic){
+    unsigned k = (unsigned)((i/(64*GAME_DEFAULT_PLAYERS)) % ctx->opt->seeds);
+    if(i % (64*GAME_DEFAULT_PLAYERS) == 0){ game_clone(g,&ctx->games[k]); *player=0; }
+    if(*player==g->playerCount){ g->roundNumber++; game_round_end(g); *player=0; }
+    if(generic) game_use_generic_engine(g);
+    if(game_take_turn(g,(PlayerId)*player)) game_clone(g,&ctx->games[k]);
+    ++*player;
+}
+
+static unsigned long long b_take_turn(BenchCtx* ctx, unsigned long long i){
+    static Game g; static int player=GAME_DEFAULT_PLAYERS;
+    take_turn_on(ctx,i,&g,&player,false); return 1;
+}
+
+// The same turns on the unspecialized engine, which tests sink, chooser and config at run time
+static unsigned long long b_take_turn_generic(BenchCtx* ctx, unsigned long long i){
+    static Game g; static int player=GAME_DEFAULT_PLAYERS;
+    take_turn_on(ctx,i,&g,&player,true); return 1;
+}
+
+// Player A entered at its entry cell with fresh MP, moving 1..6 steps in each direction
+static unsigned long long b_perform_move(BenchCtx* ctx, unsigned long long i){
+    unsigned k = (unsigned)(i % ctx->opt->seeds);
+    static Game g; game_clone(&g,&ctx->games[k]);
+    Player* p=&g.players[PLAYER_A];
+    p->inMaze=true; p->x=5; p->y=12; p->dir=(Direction)((i/6)%4);
+    game_reindex(&g); // position written directly
+    game_move_player(&g,PLAYER_A,(int)(i%6)+1);
+    benchSink += p->x;
+    return 1;
+}
+
+static unsigned long long b_resolve_teleport(BenchCtx* ctx, unsigned long long i){
+    static Game g; static bool ready=false;
+    if(!ready){ game_clone(&g,&ctx->games[0]); ready=true; }
+    const Maze* m=&ctx->boards[0].maze;
+    int cell = (int)(i % (unsigned)m->cellCount);
+    Player* p=&g.players[PLAYER_A];
+    p->floor = cell/(m->width*m->length); p->x = (cell/m->length)%m->width; p->y = cell%m->length;
+    game_resolve_teleport(&g,PLAYER_A);
+    benchSink += p->floor;
+    return 1;
+}
+
+static unsigned long long b_apply_effect(BenchCtx* ctx, unsigned long long i){
+    const Maze* m=&ctx->boards[0].maze;
+    int cell = (int)(i % (unsigned)m->cellCount);
+    benchSink += maze_apply_effect(m, cell/(m->width*m->length), (cell/m->length)%m->width, cell%m->length, 100, NULL);
+    return 1;
+}
+
+static unsigned long long b_rng_die(BenchCtx* ctx, unsigned long long i){
+    (void)ctx; (void)i;
+    static Rng r; static bool ready=false;
+    if(!ready){ rng_seed(&r,1,RNG_STREAM_DICE); ready=true; }
+    benchSink += (int)rng_bounded(&r,6); return 1;
+}
+
+// One op = one die face, drawn 256 at a time through the batch API
+static unsigned long long b_rng_fill_dice(BenchCtx* ctx, unsigned long long i){
+    (void)ctx; (void)i;
+    static Rng r; static bool ready=false; static uint8_t buf[256];
+    if(!ready){ rng_seed(&r,1,RNG_STREAM_DICE); ready=true; }
+    rng_fill_dice(&r,buf,sizeof buf); benchSink += buf[0];
+    return sizeof buf;
+}
+
+static unsigned long long fullTurns; // turns played by b_full_game
+
+static unsigned long long b_full_game(BenchCtx* ctx, unsigned long long i){
+    unsigned k = (unsigned)(i % ctx->opt->seeds);
+    static Game g; game_clone(&g,&ctx->games[k]);
+    int winner = game_play(&g,ctx->opt->maxRounds);
+    fullTurns += (unsigned long long)g.roundNumber*g.playerCount + (winner>=0 ? (unsigned long long)winner+1 : 0); // a win ends its round early
+    return 1;
+}
+
+static unsigned long long b_full_game_generic(BenchCtx* ctx, unsigned long long i){
+    unsigned k = (unsigned)(i % ctx->opt->seeds);
+    static Game g; game_clone(&g,&ctx->games[k]);
+    game_use_generic_engine(&g);
+    benchSink += game_play(&g,ctx->opt->maxRounds);
+    return 1;
+}
+
+static void print_result(const BenchResult* r, bool last){
+    double ops = r->ops ? (double)r->ops : 1.0;
+    printf("    {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"allocs\": %llu, \"allocs_per_op\": %.4f}%s\n",
+        r->name, r->ops, r->ns/ops, ops*1e9/(r->ns>0?r->ns:1.0), r->allocs, (double)r->allocs/ops, last?"":",");
+}
+
+int main(int argc, char** argv){
+    BenchOptions opt = { 64, 2000, 200.0 };
+    for(int i=1;i<argc;++i){
+        if(strcmp(argv[i],"--seeds")==0 && i+1<argc) opt.seeds=(unsigned)strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--max-rounds")==0 && i+1<argc) opt.maxRounds=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--min-ms")==0 && i+1<argc) opt.minMs=atof(argv[++i]);
+        else { fprintf(stderr,"usage: %s [--seeds N] [--max-rounds R] [--min-ms M]\n", argv[0]); return 1; }
+    }
+    if(opt.seeds<1) opt.seeds=1;
+    BenchCtx ctx = { &opt, util_aligned_calloc(opt.seeds,sizeof(Board),_Alignof(Board)), calloc(opt.seeds,sizeof(Game)) };
+    if(!ctx.boards || !ctx.games){ fprintf(stderr,"out of memory\n"); return 1; }
+    for(unsigned k=0;k<opt.seeds;++k){
+        board_init(&ctx.boards[k],k+1);
+        game_init_from_board(&ctx.games[k],&ctx.boards[k],k+1);
+        game_set_sink(&ctx.games[k],NULL,NULL);
+    }
+
+    BenchResult results[12]; int n=0;
+    results[n++] = run_bench("maze_init", &ctx, b_maze_init);
+    results[n++] = run_bench("board_init", &ctx, b_board_init);
+    results[n++] = run_bench("game_init", &ctx, b_game_init);
+    results[n++] = run_bench("game_take_turn", &ctx, b_take_turn);
+    results[n++] = run_bench("game_take_turn_generic", &ctx, b_take_turn_generic);
+    results[n++] = run_bench("perform_move", &ctx, b_perform_move);
+    results[n++] = run_bench("resolve_stair_or_pole", &ctx, b_resolve_teleport);
+    results[n++] = run_bench("maze_apply_effect", &ctx, b_apply_effect);
+    results[n++] = run_bench("rng_bounded_die", &ctx, b_rng_die);
+    results[n++] = run_bench("rng_fill_dice", &ctx, b_rng_fill_dice);
+    fullTurns = 0;
+    results[n++] = run_bench("full_game", &ctx, b_full_game);
+    const BenchResult* full=&results[n-1];
+    results[n++] = run_bench("full_game_generic", &ctx, b_full_game_generic);
+    const BenchResult* fullGeneric=&results[n-1];
+    const BenchResult* turn=&results[3]; const BenchResult* turnGeneric=&results[4];
+
+    printf("{\n  \"seeds\": %u,\n  \"max_rounds\": %d,\n  \"benchmarks\": [\n", opt.seeds, opt.maxRounds);
+    for(int i=0;i<n;++i) print_result(&results[i], i==n-1);
+    printf("  ],\n  \"full_game\": {\"games_per_sec\": %.2f, \"turns\": %llu, \"turns_per_sec\": %.0f},\n",
+        (double)full->ops*1e9/full->ns, fullTurns, (double)fullTurns*1e9/full->ns);
+    // Generic over specialized time per op: above 1 means the specialized variant is faster
+    printf("  \"engine_specialization\": {\"take_turn_speedup\": %.3f, \"full_game_speedup\": %.3f}\n}\n",
+        (turnGeneric->ns/(double)turnGeneric->ops)/(turn->ns/(double)turn->ops), (fullGeneric->ns/(double)fullGeneric->ops)/(full->ns/(double)full->ops));
+    for(unsigned k=0;k<opt.seeds;++k) board_free(&ctx.boards[k]);
+    util_aligned_free(ctx.boards); free(ctx.games);
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef AI_H
+#define AI_H
+#include "game.h"
+
+// Monte Carlo lookahead for direction-die turns: each candidate direction is scored by the
+// flag-capture rate of random rollouts played from clones of the current Game
+typedef struct {
+    int rollouts;       // rollouts per candidate direction (upper bound)
+    double budgetMs;    // wall-clock budget per decision, <=0 = unlimited
+    int horizonRounds;  // rollout length in rounds before it counts as a loss
+    int threads;        // worker threads including the caller, <=0 = online CPUs
+    int players;        // field size the per-thread Game copies are reserved for (larger fields grow them once)
+} AiConfig;
+
+typedef struct AiPool AiPool;
+
+AiPool* ai_pool_create(const AiConfig* cfg); // preallocates threads and one Game copy per thread
+void ai_pool_destroy(AiPool* pool);
+int  ai_choose_direction(AiPool* pool, const Game* g, PlayerId pid, int moveDie);
+void ai_attach(Game* g, AiPool* pool, unsigned playerMask); // bit i = player i is AI controlled (players 0..31)
+
+#endif
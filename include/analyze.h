@@ -0,0 +1,51 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+#include "game.h"
+
+// Board analysis for one player at a time (the others are ignored: no captures between players).
+// Both modes follow the engine's rules for walls, stairs and poles under the stair schedule of
+// game_round_end, the one-way Bawana interior, cell effects, MP depletion and the direction die on
+// every 4th turn after entry. They start from g at the beginning of its current round (normally a
+// freshly initialized game) and use its flag and stair state.
+
+// Fewest turns with every die in the player's favour. Routes through Food Poisoning, Disoriented or
+// Triggered Bawana cells, or through MP depletion, are not considered.
+typedef struct {
+    int turns;    // fewest turns until the flag is captured, -1 if it cannot be reached
+    long long mp; // movement points needed at the start of those turns
+} AnalyzeReach;
+
+typedef struct {
+    int players;
+    AnalyzeReach start[GAME_MAX_PLAYERS]; // [players] from each player's starting area, counting the turns spent waiting for a 6
+    int cellCount;
+    int* cellTurns;   // [cellCount] fewest turns from a cell (best direction, die phase and round), -1 if none
+    bool exactStairs; // false when the config toggles stairs at random: every direction was assumed open
+} AnalyzeReachMap;
+
+int  analyze_reach(const Game* g, AnalyzeReachMap* out); // 0 on success, -1 out of memory
+void analyze_reach_free(AnalyzeReachMap* r);
+
+// Random dice: the distribution over (cell, direction, die phase, MP bucket) states, advanced round
+// by round. MP is exact up to ANALYZE_MP_EXACT and on a quarter-octave grid above it (values in
+// between are split between the neighbouring points), wrapping at INT32_MAX like Player's int;
+// Disoriented and Triggered count as plain MP bonuses.
+#define ANALYZE_MP_EXACT_BITS 7
+#define ANALYZE_MP_EXACT (1<<ANALYZE_MP_EXACT_BITS)
+
+typedef struct {
+    double capture; // P(flag captured within the horizon)
+    double stuck;   // P(blocked move left MP <= 0 within the horizon: the player never moves again)
+    double rounds;  // expected rounds played, capped at the horizon
+} AnalyzeOdds;
+
+typedef struct {
+    int horizon, players;
+    AnalyzeOdds player[GAME_MAX_PLAYERS]; // [players]
+    double gameOver;   // P(some player captures within the horizon), players taken as independent
+    double gameRounds; // expected game length in rounds, capped at the horizon, same assumption
+} AnalyzeExpected;
+
+int analyze_expected(const Game* g, int horizon, AnalyzeExpected* out); // 0 on success, -1 out of memory
+
+#endif
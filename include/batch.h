@@ -0,0 +1,65 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include "game.h"
+
+// Lockstep batch engine: BATCH_LANES independent headless games advance one player turn at a time,
+// all lanes on the same player. State is structure-of-arrays ([field][lane]) so every phase of a
+// turn (dice, direction, each step of a move) is one pass over the lanes with lane masks instead of
+// a branchy walk through one Game. A lane plays exactly like game_play on the Game it was loaded
+// from (same dice stream, same rules); event sinks and direction choosers are not supported. All
+// lanes play the same number of players. Captures are found by comparing the mover's cell with every
+// player's in each lane. Opt-in (--batch): it is slower than game_play at every measured field size
+// (README), and `make parity` checks that it still plays the same games.
+#define BATCH_LANES 16
+
+typedef struct {
+    uint32_t active;   // lanes holding a game (finished or not)
+    uint32_t finished; // lanes whose game is over (see winner)
+    int32_t winner[BATCH_LANES];
+    int32_t live[BATCH_LANES]; // 1 while the lane's game is in progress (active and not finished)
+    int playerCount;           // of every lane (set by batch_lane_load)
+
+    // Per lane board data (cached from the lane's Board)
+    const Board* board[BATCH_LANES];
+    const uint8_t* cells[BATCH_LANES];
+    const CellEffect* effects[BATCH_LANES];
+    int32_t rowStride[BATCH_LANES];  // cell index delta of one x step (maze length)
+    int32_t floorSize[BATCH_LANES];  // width*length
+    int32_t entranceCell[BATCH_LANES];
+
+    // Per lane game state
+    uint32_t rng[4][BATCH_LANES]; // xoshiro128++ state word k of each lane's dice stream
+    int32_t roundNumber[BATCH_LANES];
+    int32_t stairCountdown[BATCH_LANES], stairMode[BATCH_LANES];
+    uint32_t totalStairCycles[BATCH_LANES];
+    uint64_t stairUp[GAME_STAIR_WORDS][BATCH_LANES], stairDown[GAME_STAIR_WORDS][BATCH_LANES];
+    int32_t flagCell[BATCH_LANES];
+    int32_t flagReachable[BATCH_LANES]; // game_flag_reachable at load (0/1)
+    GameConfig config[BATCH_LANES];
+    int32_t watchNext[BATCH_LANES]; // GameWatch of each lane
+
+    // Per player, per lane state (Player fields; position as a cell index)
+    int32_t cell[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t mp[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t dir[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t skipTurns[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t disorientedTurns[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t bawanaEffectType[GAME_MAX_PLAYERS][BATCH_LANES], bawanaEffectTurns[GAME_MAX_PLAYERS][BATCH_LANES];
+    int32_t inMaze[GAME_MAX_PLAYERS][BATCH_LANES], randomDisoriented[GAME_MAX_PLAYERS][BATCH_LANES], triggered[GAME_MAX_PLAYERS][BATCH_LANES]; // 0/1
+    int32_t directionRollCounter[GAME_MAX_PLAYERS][BATCH_LANES], movesSinceEntry[GAME_MAX_PLAYERS][BATCH_LANES];
+    uint32_t stepsMoved[GAME_MAX_PLAYERS][BATCH_LANES], capturesDone[GAME_MAX_PLAYERS][BATCH_LANES], timesCaptured[GAME_MAX_PLAYERS][BATCH_LANES];
+    uint32_t stairsUsed[GAME_MAX_PLAYERS][BATCH_LANES], polesUsed[GAME_MAX_PLAYERS][BATCH_LANES], bawanaVisits[GAME_MAX_PLAYERS][BATCH_LANES];
+} GameBatch;
+
+void batch_init(GameBatch* b); // all lanes empty
+// Copies g (a game between rounds; its board must outlive the lane) into a lane, replacing what it held;
+// g must have the player count of the lanes already loaded
+void batch_lane_load(GameBatch* b, int lane, const Game* g);
+void batch_lane_store(const GameBatch* b, int lane, Game* g); // writes the lane's state back into g
+void batch_lane_clear(GameBatch* b, int lane);                // marks the lane empty
+// Plays whole rounds in every unfinished lane until at least one game ends (flag, maxRounds or an
+// early stop of game_watch_check, with the same GameResult in winner as game_play);
+// returns the mask of lanes that finished during the call (0 when no lane is running)
+uint32_t batch_run(GameBatch* b, int maxRounds);
+
+#endif
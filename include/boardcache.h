@@ -0,0 +1,38 @@
+#ifndef BOARDCACHE_H
+#define BOARDCACHE_H
+#include <stdint.h>
+#include <pthread.h>
+#include "game.h"
+
+// Boards by board seed, least recently used first out. A board is generated once, outside the lock,
+// and then only read, so any number of threads may play games on it at the same time. Entries in
+// use are pinned; when every entry is pinned a miss gets a private board that is freed on release.
+typedef struct BoardCacheEntry BoardCacheEntry;
+struct BoardCacheEntry {
+    Board board;
+    unsigned seed;
+    int refs;               // games holding the board
+    bool ready, failed;     // generation finished / ran out of memory (or empty slot)
+    bool overflow;          // private board outside the table
+    BoardCacheEntry* hashNext;
+    BoardCacheEntry *prev, *next; // LRU list, most recent first
+};
+
+typedef struct {
+    pthread_mutex_t mu;
+    pthread_cond_t generated; // broadcast when an entry becomes ready
+    const Maze* layout;       // NULL = built-in board
+    int capacity;
+    uint32_t bucketMask;
+    BoardCacheEntry** bucket;
+    BoardCacheEntry* entry;   // [capacity]
+    BoardCacheEntry *head, *tail;
+    unsigned long long hits, misses, overflows;
+} BoardCache;
+
+int  board_cache_init(BoardCache* c, int capacity, const Maze* layout); // 0 on success; layout must outlive the cache
+void board_cache_free(BoardCache* c); // every board released
+const Board* board_cache_acquire(BoardCache* c, unsigned seed); // NULL when out of memory
+void board_cache_release(BoardCache* c, const Board* b);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <stdio.h>
+#include <stdint.h>
+#include "game.h"
+
+// Binary checkpoint file: header | Board struct | maze arena image (once) | fixed-size game records
+// appended over time. A record is a CheckpointRecord with one CheckpointPlayer per player of the
+// game; record i lives at recordsOffset + i*recordSize, so any snapshot is one seek (or one pointer)
+// away. Fields are host byte order (little-endian on all supported targets); a
+// trailing partial record is ignored.
+#define CHECKPOINT_MAGIC "MZCKPT\r\n"
+#define CHECKPOINT_VERSION 6u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;    // sizeof(CheckpointHeader)
+    uint32_t boardSize;     // sizeof(Board) of the writer; its array pointers are rebuilt on load
+    uint32_t recordSize;    // sizeof(CheckpointRecord) + players*sizeof(CheckpointPlayer) of the writer
+    uint64_t boardOffset;
+    uint64_t arenaOffset;   // Board.maze.arena image, 64-byte aligned
+    uint64_t arenaSize;
+    uint64_t recordsOffset;
+    uint32_t boardSeed;
+    uint32_t players;       // Game.playerCount
+    uint32_t diceSeed;      // Game.seed
+    uint32_t reserved;
+} CheckpointHeader; // 72 bytes
+
+typedef struct {
+    int32_t floor, x, y, inMaze, dir;
+    int32_t movementPoints, skipTurns, randomDisoriented, triggered, disorientedTurnsRemaining;
+    int32_t bawanaEffectType, bawanaEffectTurns;
+    int32_t directionRollCounter, movesSinceEntry;
+    uint32_t stepsMoved, capturesDone, timesCaptured, stairsUsed, polesUsed, bawanaVisits;
+} CheckpointPlayer;
+
+typedef struct {
+    int32_t roundNumber;
+    uint32_t rng[4];
+    int32_t stairDirectionChangeCountdown, stairDirectionMode;
+    uint64_t stairUp[GAME_STAIR_WORDS], stairDown[GAME_STAIR_WORDS];
+    int32_t flagFloor, flagX, flagY;
+    int32_t stairCycleRounds;
+    uint8_t forceOneWay, alternateDirections, pad[2];
+    uint32_t totalStairCycles;
+    CheckpointPlayer players[]; // [header players]
+} CheckpointRecord;
+
+typedef struct {
+    FILE* f;
+    uint64_t count; // records in file
+    uint64_t recordsOffset;
+    uint32_t recordSize;
+    CheckpointRecord* record; // scratch record of recordSize bytes
+} CheckpointWriter;
+
+// Mapped (read-only) view of a checkpoint file
+typedef struct {
+    void* base;
+    size_t size;
+    const CheckpointHeader* header;
+    Board* board; // heap copy of the stored struct, maze arrays point into the mapping
+    const char* records; // record i at records + i*header->recordSize (checkpoint_record)
+    uint64_t count;
+} Checkpoint;
+
+// 0 on success; an appended file must hold the same board and player count
+int  checkpoint_writer_open(CheckpointWriter* w, const char* path, const Game* g, bool append);
+int  checkpoint_append(CheckpointWriter* w, const Game* g);
+int  checkpoint_writer_rewind(CheckpointWriter* w, int round); // drop records at or after round (resume mid-file)
+void checkpoint_writer_close(CheckpointWriter* w);
+
+int  checkpoint_map(Checkpoint* c, const char* path); // 0 on success
+void checkpoint_unmap(Checkpoint* c);
+static inline const CheckpointRecord* checkpoint_record(const Checkpoint* c, uint64_t i){ return (const CheckpointRecord*)(c->records+i*c->header->recordSize); }
+int64_t checkpoint_find_round(const Checkpoint* c, int round); // record index or -1
+int  checkpoint_restore(const Checkpoint* c, uint64_t index, Game* g); // g->board points into the mapping; -1 for a record no game can reach or out of memory
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "game.h"
+
+// Binary event log: header | blocks. A block is {stream, count} followed by count 16-byte records.
+// Each writer (one per thread) owns a stream id and buffers records until a whole block is written
+// with one fwrite, so several writers can share a file; a reader follows one stream to see its games
+// in order. Fields are host byte order (little-endian on all supported targets).
+#define EVLOG_MAGIC "MZEVLOG\n"
+#define EVLOG_VERSION 3u
+#define EVLOG_BLOCK_RECORDS 32768u // 512 KB per write
+
+// Log-only record types, beyond GameEventType
+enum {
+    EVLOG_GAME_BEGIN=0x80, // value = seed, other = player count
+    EVLOG_GAME_END=0x81,   // value = rounds played, player = winner (-1 none), other = -GameResult when none
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(EventLogRecord)
+} EventLogHeader;
+
+typedef struct {
+    uint32_t stream;
+    uint32_t count;
+} EventLogBlock;
+
+typedef struct {
+    uint8_t type;   // GameEventType or EVLOG_*
+    uint8_t reserved;
+    uint16_t player, other; // 0xFFFF = -1
+    uint16_t floor, x, y; // raw coordinates, so decoding needs no board dimensions
+    int32_t value;
+} EventLogRecord;
+
+typedef struct {
+    FILE* f;
+    pthread_mutex_t mu; // serializes block writes
+    bool failed;
+} EventLogFile;
+
+// Per-thread writer; also a GameEventSink that forwards to an optional next sink
+typedef struct {
+    EventLogFile* file;
+    EventLogBlock* block; // block header followed by the record buffer
+    EventLogRecord* records;
+    GameEventSink next;
+    void* nextUser;
+} EventLog;
+
+int  eventlog_file_open(EventLogFile* lf, const char* path); // 0 on success
+int  eventlog_file_close(EventLogFile* lf);                  // 0 if every write succeeded
+int  eventlog_init(EventLog* log, EventLogFile* lf, uint32_t stream); // 0 on success
+void eventlog_free(EventLog* log); // flushes
+int  eventlog_flush(EventLog* log);
+void eventlog_begin_game(EventLog* log, unsigned seed, int players); // seed = Game.seed (the dice seed)
+void eventlog_end_game(EventLog* log, const Game* g, int winner);
+void eventlog_sink(const GameEvent* ev, void* user); // user = EventLog*
+void eventlog_attach(EventLog* log, Game* g);        // chains the game's current sink behind the log
+
+// Mapped (read-only) view of a log file
+typedef struct {
+    void* base;
+    size_t size;
+} EventLogMap;
+
+// Walks the records of one stream (or every stream with EVLOG_ALL_STREAMS) in file order
+#define EVLOG_ALL_STREAMS UINT32_MAX
+typedef struct {
+    const EventLogMap* map;
+    uint32_t stream;
+    size_t blockOffset;    // offset of the current block header
+    uint32_t blockStream;  // stream of the current block
+    uint32_t index, count; // position within the current block
+    bool truncated;        // current block was cut short by end of file: it is the last one
+} EventLogCursor;
+
+int  eventlog_map(EventLogMap* m, const char* path); // 0 on success
+void eventlog_unmap(EventLogMap* m);
+void eventlog_cursor_init(EventLogCursor* c, const EventLogMap* m, uint32_t stream);
+const EventLogRecord* eventlog_next(EventLogCursor* c); // NULL at end of file
+void eventlog_decode(const EventLogRecord* r, GameEvent* ev);
+
+#endif
@@ -5,7 +5,11 @@
 
 typedef enum { DIR_N=0, DIR_E=1, DIR_S=2, DIR_W=3 } Direction;
 
-typedef enum { PLAYER_A=0, PLAYER_B=1, PLAYER_C=2, PLAYER_COUNT=3 } PlayerId;
+typedef enum { PLAYER_A=0, PLAYER_B=1, PLAYER_C=2 } PlayerId; // any id below Game.playerCount is valid
+
+#define GAME_DEFAULT_PLAYERS 3 // A, B and C of the rules
+#define GAME_MAX_PLAYERS 256   // game_set_players limit
+#define GAME_INLINE_PLAYERS 4  // players stored in the Game itself; larger fields use its heap block (game_free)
 
 typedef struct {
     int floor;
@@ -20,6 +24,9 @@ typedef struct {
     int disorientedTurnsRemaining;
     int bawanaEffectType; // -1 none, 0 poisoning,1 disoriented,2 triggered,3 happy,4 randomMP
     int bawanaEffectTurns; // remaining for timed effects
+    int directionRollCounter; // turns taken
+    int movesSinceEntry; // in-maze turns since entering; the direction die rolls on every 4th
+    int occNext; // next player on the same cell in the occupancy index, -1 last
     // Stats
     unsigned stepsMoved;
     unsigned capturesDone;
@@ -35,25 +42,134 @@ typedef struct {
     bool alternateDirections;      // if true alternate up/down per cycle globally
 } GameConfig;
 
+// Engine events; every bit of output from game.c is routed through an optional sink
+typedef enum {
+    GAME_EVENT_ENTER=0,       // player entered maze at (x,y)
+    GAME_EVENT_SKIP,          // value = skip turns remaining
+    GAME_EVENT_MP_DEPLETED,   // movement points ran out, player sent to Bawana
+    GAME_EVENT_BAWANA,        // value = Bawana effect type code
+    GAME_EVENT_CAPTURE,       // other = captured player
+    GAME_EVENT_FLAG,          // value = 1 when captured on entry
+    GAME_EVENT_STAIR_CYCLE,   // value = cycle number, other = 1 for UP mode
+    GAME_EVENT_AI_DIRECTION,  // value = Direction picked by the chooser
+    GAME_EVENT_STEP,          // moved one cell to (floor,x,y), value = MP after the cell effect
+    GAME_EVENT_BLOCKED,       // wall/Bawana penalty at (floor,x,y), value = MP after penalty
+    GAME_EVENT_STAIR,         // arrived at (floor,x,y), value = stair index, other = 1 for up
+    GAME_EVENT_POLE,          // arrived at (floor,x,y), value = pole index
+    GAME_EVENT_ROUND,         // value = round number now starting (emitted by game_round_end)
+} GameEventType;
+
 typedef struct {
-    Maze maze;
-    Player players[PLAYER_COUNT];
-    unsigned rng;
-    int roundNumber; // each full set of 3 turns
-    int directionRollCounter[PLAYER_COUNT];
-    int movesSinceEntry[PLAYER_COUNT];
+    GameEventType type;
+    int player;
+    int other;
+    int value;
+    int floor, x, y;
+} GameEvent;
+
+typedef void (*GameEventSink)(const GameEvent* ev, void* user);
+
+struct Game;
+typedef struct GameEngine GameEngine; // turn engine variant (game.c)
+// Called on direction-die turns; returns a Direction to override the die, or -1 to keep it
+typedef int (*GameDirectionChooser)(const struct Game* g, PlayerId pid, int moveDie, void* user);
+
+// Everything derived from the seed that never changes during play; many games may share one.
+// The maze arrays (including the Bawana type map) live in maze.arena; release with board_free.
+typedef struct {
+    _Alignas(64) Maze maze;
+    unsigned seed;
+} Board;
+
+#define GAME_STAIR_WORDS (MAX_STAIRS/64)
+
+// Occupancy index: the in-maze players of every occupied cell, so a capture check is one lookup.
+// Open addressing with linear probing on the cell index, at most half full; each slot heads a list
+// (Player.occNext) of the players on its cell in id order. Kept up to date by the engine as players
+// enter, move, teleport and get captured; code that writes positions directly calls game_reindex.
+#define GAME_OCC_EMPTY INT32_MIN
+typedef struct { int32_t cell, head; } GameOccSlot;
+
+// Per-game mutable state only. Players and occupancy slots live in the inline arrays up to
+// GAME_INLINE_PLAYERS players and in one heap block beyond that, so the Game of a default 3-player
+// game stays small. The block stays with the Game across games until game_free, and is only replaced
+// when a larger field needs more. Copy with game_clone (never by assignment: players/occ may point
+// into the Game, and the block is owned by one Game).
+typedef struct Game {
+    const Board* board;
+    Rng rng; // dice stream (RNG_STREAM_DICE of the seed)
+    unsigned seed; // dice seed; board->seed is the board's, and the two need not match
+    int roundNumber; // each full set of playerCount turns
     int stairDirectionChangeCountdown; // for Rule 6 (every 5 rounds)
     int stairDirectionMode; // toggles
-    int bawanaTypes[BAWANA_X_MAX-BAWANA_X_MIN+1][BAWANA_Y_MAX-BAWANA_Y_MIN+1]; // mapping interior cells to type codes
+    uint64_t stairUp[GAME_STAIR_WORDS], stairDown[GAME_STAIR_WORDS]; // enabled directions, bit i = board stair i
+    int flagFloor, flagX, flagY; // copied from board, may be overridden (fastflag)
     GameConfig config;
     unsigned totalStairCycles;
+    GameEventSink sink; // NULL = headless (no output)
+    void* sinkUser;
+    GameDirectionChooser chooseDirection; // NULL = dice only
+    void* chooserUser;
+    const GameEngine* engine; // variant for the sink, chooser and config; set with them, never directly
+    int playerCount;
+    uint32_t occMask; // occ slots in use - 1
+    Player* players;  // [playerCount]: inlinePlayers or heap
+    GameOccSlot* occ; // [occMask+1]: inlineOcc or heap, after the players
+    void* heap;       // owned block for more than GAME_INLINE_PLAYERS players, NULL = none
+    int heapPlayers;  // players the block holds (0 = none)
+    GameOccSlot inlineOcc[2*GAME_INLINE_PLAYERS]; // game_clone copies the fields before players only
+    Player inlinePlayers[GAME_INLINE_PLAYERS];
 } Game;
 
-void game_init(Game* g, unsigned seed);
+// Ends of a game other than a winner's PlayerId (game_play, batch lanes, maze_game)
+typedef enum {
+    GAME_RESULT_CAPPED=-1,     // round cap reached without a capture
+    GAME_RESULT_UNWINNABLE=-2, // the flag is on no cell a player can ever stand on
+    GAME_RESULT_STALLED=-3,    // every player is out of MP for good: nobody moves again
+} GameResult;
+
+// Early termination for loops that play whole rounds. A check at the first round and then every
+// GAME_WATCH_INTERVAL rounds tests the flag cell's CELL_REACHABLE marker and game_stalled. The dice
+// stream never repeats, so a repeated position is no loop by itself; game_stalled is the exact test
+// for a game that can no longer end.
+#define GAME_WATCH_INTERVAL 64
+typedef struct {
+    int nextRound; // round of the next sample
+} GameWatch;
+
+#define GAME_HASH_SEED 0xcbf29ce484222325ull
+static inline uint64_t game_hash_step(uint64_t h, uint32_t v){ return (h^v)*0x100000001b3ull; } // FNV-1a on words
+
+void board_init(Board* b, unsigned seed); // default layout; b must be zeroed or previously initialized
+int  board_init_from_layout(Board* b, const Maze* layout, unsigned seed); // layout from maze_parse/maze_load_file
+void board_free(Board* b);
+// g/dst must be zeroed or previously initialized (the heap block of a large field is kept for reuse)
+void game_init_from_board(Game* g, const Board* b, unsigned seed); // seed = dice seed (0 = time), independent of b->seed
+void game_init(Game* g, Board* b, unsigned seed); // board_init into caller storage + game_init_from_board, one seed for both
+int  game_set_players(Game* g, int count); // before play: count fresh players (1..GAME_MAX_PLAYERS), 0 on success, -1 also when out of memory
+void game_set_config(Game* g, GameConfig c); // before play: replaces the default rules and restarts the stair cycle
+int  game_reserve(Game* g, int count); // heap block for count players ahead of play (no-op up to GAME_INLINE_PLAYERS); 0 or -1
+int  game_clone(Game* dst, const Game* src); // 0 on success; -1 only when dst's block is too small and out of memory
+void game_free(Game* g); // releases the heap block (a large field has no players until initialized again)
+void game_reindex(Game* g); // rebuild the occupancy index after writing player positions directly
 void game_print_status(const Game* g);
 bool game_take_turn(Game* g, PlayerId p);
+bool game_resume_turn(Game* g, PlayerId p, int moveDie); // rest of a turn after dice/direction are settled
 void game_print_help();
 void game_round_end(Game* g); // call after all players acted each round
 void game_print_summary(const Game* g);
+void game_set_sink(Game* g, GameEventSink sink, void* user);
+void game_set_chooser(Game* g, GameDirectionChooser chooser, void* user);
+void game_use_generic_engine(Game* g); // benchmarks: the unspecialized engine, until the next sink/chooser/config change
+void game_print_event(const GameEvent* ev, void* user); // default stdout sink
+int  game_play(Game* g, int maxRounds); // run headless loop, returns winner or a GameResult
+const char* game_result_text(int result); // "flag unreachable" etc. for a GameResult
+bool game_flag_reachable(const Game* g);
+bool game_stalled(const Game* g); // no player can move or capture the flag again
+void game_watch_init(GameWatch* w, const Game* g);
+int  game_watch_check(GameWatch* w, const Game* g); // call before each round: 0 keep playing, else a GameResult
+// Both keep the occupancy index current; a stale one (a position written directly) is rebuilt on the way
+void game_move_player(Game* g, PlayerId p, int steps); // perform_move only
+void game_resolve_teleport(Game* g, PlayerId p);       // stair/pole resolution at current cell
 
 #endif
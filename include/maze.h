@@ -1,18 +1,29 @@
 #ifndef MAZE_H
 #define MAZE_H
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include "random.h"
 
-#define FLOORS 3
-#define WIDTH 10
-#define LENGTH 25
+// Board dimensions come from the maze description (see mazes/default.maze); these bound them
+#define MAZE_MAX_DIM 65535          // floors, width and length each
+#define MAZE_MAX_CELLS (1u<<28)     // floors*width*length
+#define MAZE_MAX_STARTS 8
 
-// Cell feature flags
+// Cell feature flags (bit index matches Direction N,E,S,W in game.h)
 #define CELL_WALL_N  (1u<<0)
 #define CELL_WALL_E  (1u<<1)
 #define CELL_WALL_S  (1u<<2)
 #define CELL_WALL_W  (1u<<3)
 
+// Per-cell state byte: open directions (same bit order), plus existence, teleport and Bawana markers
+#define CELL_OPEN_N   (1u<<0)
+#define CELL_OPEN_MASK 0x0Fu
+#define CELL_VALID    (1u<<4)
+#define CELL_TELEPORT (1u<<5) // has an entry in teleportCells
+#define CELL_BAWANA   (1u<<6) // inside the Bawana region (maze_is_bawana)
+#define CELL_REACHABLE (1u<<7) // a player can be standing here at the end of some turn (maze_build_reach_table)
+
 // Bonus / consumable types
 typedef enum {
     CELL_EFFECT_NONE=0,
@@ -22,17 +33,17 @@ typedef enum {
 } CellEffectType;
 
 typedef struct {
-    CellEffectType type;
-    int value; // meaning depends on type
+    uint8_t type; // CellEffectType
+    int8_t value; // meaning depends on type
 } CellEffect;
 
 // Stair definition (possibly dynamic direction)
 typedef struct {
     int startFloor, startX, startY;
     int endFloor, endX, endY;
-    bool bidirectional; // for base rules true, for Rule 6 can toggle
-    bool enabledUp;     // dynamic
-    bool enabledDown;   // dynamic
+    bool bidirectional; // initial state; per-game state lives in Game.stairUp/stairDown
+    bool enabledUp;     // initial state
+    bool enabledDown;   // initial state
 } Stair;
 
 // Pole definition
@@ -42,38 +53,107 @@ typedef struct {
     int x, y;
 } Pole;
 
-#define MAX_STAIRS 64
-#define MAX_POLES 32
+#define MAX_STAIRS 256 // per-game enable bits are fixed-size (Game.stairUp/stairDown)
+
+// Teleport codes: 2i stair i up, 2i+1 stair i down, TELEPORT_POLE_BASE+j pole j
+#define TELEPORT_POLE_BASE (2u*MAX_STAIRS)
+
+// Candidate transitions of one cell, in precedence order (stairs in order, start before end, then poles)
+typedef struct { uint32_t cell, first, count; } TeleportCell;
+
+typedef struct {
+    int floor;
+    int xMin, xMax, yMin, yMax; // interior, inclusive
+    int entranceX, entranceY;   // the only cell interior moves may come from
+} BawanaRegion;
+
+// Starting area spot of one player and the maze cell a roll of 6 enters at
+typedef struct {
+    int floor, x, y;
+    int entryX, entryY;
+    int dir; // Direction
+} MazeStart;
 
+// Growable working memory for the table builders and maze_randomize; reused across calls, so
+// regenerating a board for the next seed touches no allocator once it has grown to size
 typedef struct {
-    CellEffect effects[FLOORS][WIDTH][LENGTH];
-    bool valid[FLOORS][WIDTH][LENGTH]; // cells that exist per floor design
-    unsigned walls[FLOORS][WIDTH][LENGTH]; // bitmask of CELL_WALL_*
+    void* base;
+    size_t capacity;
+} MazeScratch;
+
+// Straight runs: a step onto a plain cell (open, no stair or pole, outside the Bawana region) does
+// nothing but apply the cell's effect, so a move can cover that stretch in a tight loop
+#define MAZE_RUN_MAX 12 // longest move: a 6 doubled by Triggered
+
+// Board geometry plus the per-seed effects/flag. Every array lives in one contiguous arena
+// sized from the description, so boards of any size keep the struct itself small.
+typedef struct {
+    int floors, width, length;
+    int cellCount;
+    int stairCount, poleCount, teleportCellCount;
+    int bawanaArea;
+    BawanaRegion bawana;
+    MazeStart starts[MAZE_MAX_STARTS];
+    int startCount;
+    int effectPercent[4]; // none, consume, small add, large add; multipliers take the rest
     int flagFloor, flagX, flagY;
 
-    Stair stairs[MAX_STAIRS];
-    int stairCount;
-    Pole poles[MAX_POLES];
-    int poleCount;
+    void* arena;
+    size_t arenaSize;     // bytes in use (the serialized image)
+    size_t arenaCapacity; // bytes allocated; 0 when attached to a mapped image
+    bool defaultLayout;   // arena holds maze_default_description as parsed: maze_init skips the parse
+    MazeScratch scratch;  // owned by this Maze, not part of the image
+    Stair* stairs;
+    Pole* poles;
+    TeleportCell* teleportCells; // sorted by cell
+    uint32_t* teleportCodes;
+    CellEffect* effects; // [cellCount]
+    uint8_t* cells;      // [cellCount] CELL_VALID | CELL_TELEPORT | CELL_BAWANA | CELL_REACHABLE | open directions
+    uint8_t* walls;      // [cellCount] bitmask of CELL_WALL_*
+    int8_t* bawanaTypes; // [bawanaArea] Bawana effect per interior cell, x-major (filled by board_init)
+    uint8_t* runs;       // [cellCount*4] plain cells straight ahead of (cell*4+direction), up to MAZE_RUN_MAX
 } Maze;
 
-void maze_init(Maze* m, unsigned seed);
-bool maze_in_bounds(int f,int x,int y);
+// Layout: parse a description (text or file) into m, reusing its arena when it is large enough.
+// m must be zeroed or previously initialized; err receives a message on failure.
+int  maze_parse(Maze* m, const char* text, char* err, size_t errSize);
+int  maze_load_file(Maze* m, const char* path, char* err, size_t errSize);
+int  maze_copy(Maze* dst, const Maze* src);
+int  maze_attach(Maze* m, void* arena, size_t size); // point m's arrays into an image of its arena (counts already set); -1 when the counts are out of range, need other than size bytes or the arrays lead outside the maze
+void maze_free(Maze* m);
+bool maze_equal(const Maze* a, const Maze* b);
+extern const char maze_default_description[];
+
+void maze_randomize(Maze* m, unsigned seed); // effect distribution and flag for one seed
+void maze_init(Maze* m, unsigned seed);      // default layout (parsed once per Maze) + maze_randomize
+void* maze_scratch_reserve(MazeScratch* s, size_t bytes); // NULL when out of memory; contents are not kept
+bool maze_in_bounds(const Maze* m,int f,int x,int y);
 bool maze_cell_exists(const Maze* m,int f,int x,int y);
 int  maze_apply_effect(const Maze* m,int f,int x,int y,int movementPoints,int* consumed);
-int  maze_random_effect_value(CellEffectType t, unsigned* rngState);
+int  maze_random_effect_value(CellEffectType t, Rng* rng);
 void maze_add_wall_line(Maze* m,int f,int x1,int y1,int x2,int y2);
+void maze_build_step_table(Maze* m); // call after any change to valid/walls/Bawana region
+void maze_build_teleport_table(Maze* m); // call after any change to stair/pole geometry
+void maze_build_reach_table(Maze* m);    // CELL_REACHABLE markers; call after the two tables above
+void maze_build_run_table(Maze* m);      // straight runs; likewise
+const TeleportCell* maze_find_teleport(const Maze* m, int cell); // NULL for plain cells
+
+static inline int maze_cell_index(const Maze* m,int f,int x,int y){ return (f*m->width+x)*m->length+y; }
+static inline int maze_dir_delta(const Maze* m, int d){ return d==0 ? -m->length : d==2 ? m->length : d==1 ? 1 : -1; } // cell index step N,E,S,W
 
-// Bawana area (assumptions documented in README)
-#define BAWANA_X_MIN 6
-#define BAWANA_X_MAX 9
-#define BAWANA_Y_MIN 21  // interior starts one row below north wall at y=20
-#define BAWANA_Y_MAX 24
-#define BAWANA_ENTRANCE_X 9
-#define BAWANA_ENTRANCE_Y 19 // entrance just outside north wall per spec (9,19)
-static inline bool is_bawana_cell(int f,int x,int y){
-    return f==0 && x>=BAWANA_X_MIN && x<=BAWANA_X_MAX && y>=BAWANA_Y_MIN && y<=BAWANA_Y_MAX;
+// Every effect is affine in MP; written without branches on the type for the batch engine's vectorizer
+static inline int32_t maze_effect_apply(int32_t mp, CellEffect e){
+    int32_t v=e.value;
+    int32_t add = e.type==CELL_EFFECT_ADD ? v : e.type==CELL_EFFECT_CONSUME ? -v : 0;
+    return e.type==CELL_EFFECT_MULTIPLY ? mp*v : mp+add;
+}
+
+static inline bool maze_is_bawana(const Maze* m,int f,int x,int y){
+    const BawanaRegion* b=&m->bawana;
+    return f==b->floor && x>=b->xMin && x<=b->xMax && y>=b->yMin && y<=b->yMax;
+}
+static inline bool maze_is_bawana_entrance(const Maze* m,int f,int x,int y){
+    return f==m->bawana.floor && x==m->bawana.entranceX && y==m->bawana.entranceY;
 }
-static inline bool is_bawana_entrance(int f,int x,int y){ return f==0 && x==BAWANA_ENTRANCE_X && y==BAWANA_ENTRANCE_Y; }
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-phase engine counters, compiled in with -DGAME_PROFILE (make PROFILE=1); without it every
+// hook below expands to nothing. Each thread counts into its own block, which is merged into the
+// process totals when the thread exits. Timed phases nest (turn covers move, move covers bawana),
+// so their times are inclusive; counted-only phases are too short to time without distorting them.
+typedef enum {
+    PROF_TURN,        // timed: game_take_turn
+    PROF_SKIP,        // timed: a skipped turn (poisoning), including the relocation when it ends
+    PROF_DICE,        // counted: movement and direction die rolls
+    PROF_ENTRY,       // timed: entering the maze on a 6
+    PROF_MOVE,        // timed: perform_move
+    PROF_STEP,        // counted: cells stepped onto
+    PROF_RUN,         // counted: straight runs over plain cells in headless games (their cells count as steps)
+    PROF_BLOCKED,     // counted: blocked steps (wall, bounds or the one-way Bawana interior)
+    PROF_STAIR,       // counted: stairs taken
+    PROF_POLE,        // counted: poles taken
+    PROF_BAWANA,      // timed: Bawana effect application
+    PROF_CAPTURE,     // timed: the capture check after a move
+    PROF_CAPTURED,    // counted: players sent back to their start
+    PROF_ROUND_END,   // timed: game_round_end
+    PROF_STAIR_CYCLE, // timed: stair direction cycles inside game_round_end
+    PROF_PHASE_COUNT
+} ProfilePhase;
+
+typedef struct {
+    uint64_t count, ticks;
+    uint64_t samples; // SIGPROF samples that landed in this phase (innermost timed phase)
+} ProfileCounter;
+
+typedef struct {
+    ProfileCounter phase[PROF_PHASE_COUNT];
+    uint64_t samplesOutside; // samples outside any timed phase (drivers, output, bookkeeping)
+    int threads;             // threads that contributed
+    double nsPerTick;
+} ProfileReport;
+
+const char* profile_phase_name(ProfilePhase p);
+bool profile_enabled(void); // false when built without GAME_PROFILE
+int  profile_start(int sampleHz); // resets the totals; sampleHz > 0 also starts the SIGPROF sampler. 0 on success
+void profile_stop(ProfileReport* out); // stops the sampler; totals of exited threads plus the calling thread
+int  profile_write(const ProfileReport* r, const char* path); // CSV when the path ends in .csv, else JSON
+
+#ifdef GAME_PROFILE
+typedef struct ProfileBlock ProfileBlock;
+struct ProfileBlock {
+    ProfileCounter phase[PROF_PHASE_COUNT];
+    uint64_t samplesOutside;
+    volatile int current; // innermost timed phase, -1 outside; read by the SIGPROF handler
+    ProfileBlock* next;
+};
+extern _Thread_local ProfileBlock* profile_tls;
+ProfileBlock* profile_thread_block(void); // registers the calling thread on first use
+uint64_t profile_ticks(void);
+
+static inline ProfileBlock* profile_block(void){ return profile_tls ? profile_tls : profile_thread_block(); }
+static inline void profile_count(ProfilePhase p){ profile_block()->phase[p].count++; }
+static inline void profile_add(ProfilePhase p, uint64_t n){ profile_block()->phase[p].count+=n; }
+static inline int profile_enter(ProfilePhase p){ ProfileBlock* b=profile_block(); int outer=b->current; b->current=(int)p; return outer; }
+static inline void profile_leave(ProfilePhase p, int outer, uint64_t t0){
+    ProfileBlock* b=profile_tls;
+    b->phase[p].count++; b->phase[p].ticks+=profile_ticks()-t0; b->current=outer;
+}
+#define PROFILE_COUNT(p) profile_count(p)
+#define PROFILE_ADD(p,n) profile_add(p,(uint64_t)(n))
+#define PROFILE_BEGIN(p) int prof_outer_##p=profile_enter(p); uint64_t prof_t0_##p=profile_ticks()
+#define PROFILE_END(p) profile_leave(p,prof_outer_##p,prof_t0_##p)
+#else
+#define PROFILE_COUNT(p) ((void)0)
+#define PROFILE_ADD(p,n) ((void)0)
+#define PROFILE_BEGIN(p) ((void)0)
+#define PROFILE_END(p) ((void)0)
+#endif
+
+#endif
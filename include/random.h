@@ -0,0 +1,45 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// xoshiro128++: 128-bit state, 32-bit outputs, period 2^128-1; all engine randomness goes through this
+typedef struct { uint32_t s[4]; } Rng;
+
+// Independent stream ids derived from one seed (replaces XOR-ing the seed per consumer)
+enum { RNG_STREAM_DICE=0, RNG_STREAM_MAZE=1, RNG_STREAM_BAWANA=2, RNG_STREAM_ROLLOUT=3 };
+
+void rng_seed(Rng* r, uint64_t seed, uint64_t stream); // splitmix64-expanded, never all-zero
+void rng_jump(Rng* r);      // advance 2^64 draws
+void rng_long_jump(Rng* r); // advance 2^96 draws
+Rng  rng_split(Rng* r);     // returns a stream of 2^64 draws; r jumps past it (non-overlapping)
+void rng_fill_dice(Rng* r, uint8_t* out, size_t n); // n unbiased die faces 1..6
+
+static inline uint32_t rng_rotl(uint32_t x, int k){ return (x<<k)|(x>>(32-k)); }
+
+static inline uint32_t rng_next(Rng* r){
+    uint32_t* s=r->s;
+    uint32_t result = rng_rotl(s[0]+s[3],7)+s[0];
+    uint32_t t = s[1]<<9;
+    s[2]^=s[0]; s[3]^=s[1]; s[1]^=s[2]; s[0]^=s[3];
+    s[2]^=t; s[3]=rng_rotl(s[3],11);
+    return result;
+}
+
+static inline uint64_t rng_next64(Rng* r){ uint64_t hi=rng_next(r); return (hi<<32)|rng_next(r); }
+
+// Unbiased draw in [0,bound) (Lemire's multiply-shift with rejection)
+static inline uint32_t rng_bounded(Rng* r, uint32_t bound){
+    uint64_t m = (uint64_t)rng_next(r)*bound;
+    uint32_t l = (uint32_t)m;
+    if(l < bound){
+        uint32_t threshold = (0u-bound) % bound;
+        while(l < threshold){ m=(uint64_t)rng_next(r)*bound; l=(uint32_t)m; }
+    }
+    return (uint32_t)(m>>32);
+}
+
+static inline bool rng_bit(Rng* r){ return (rng_next(r)>>31)!=0; } // top bit, the strongest one
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef RENDER_H
+#define RENDER_H
+#include <stdio.h>
+#include <stdint.h>
+#include "game.h"
+
+// Live ANSI board view. The floors are stacked top to bottom under a status area, two columns per
+// cell: its glyph, then '|' for a wall to the east; a wall to the south underlines the glyph. The
+// board layer is drawn once from the maze; each frame overlays the flag and players, compares the
+// result with the frame on screen and writes only the changed cells, in one write.
+typedef struct {
+    uint8_t ch;
+    uint8_t attr; // RENDER_ATTR_* colour, RENDER_UNDERLINE
+} RenderCell;
+
+typedef struct {
+    FILE* out;
+    int rows, cols;         // screen cells
+    int boardRow;           // first board row (below the status area)
+    int statusRows;
+    RenderCell* base;       // [rows*cols] static board layer
+    RenderCell* back;       // frame being composed
+    RenderCell* front;      // frame on screen
+    char* buf;              // escape sequences of one frame
+    size_t len, cap;
+    double minInterval;     // seconds between frames, 0 = draw every frame
+    double lastFrame;
+    double turnInterval;    // seconds per turn (render_turn), 0 = as fast as the game runs
+    double start;
+    unsigned long long turns;
+    unsigned long long frames, skipped;
+} Renderer;
+
+// fps <= 0 draws every frame, tps <= 0 leaves the game unthrottled; 0 on success
+int  render_init(Renderer* r, FILE* out, const Game* g, int fps, int tps);
+void render_free(Renderer* r); // leaves the cursor below the board
+bool render_frame(Renderer* r, const Game* g, bool force); // draws if a frame is due (always with force); true when drawn
+bool render_turn(Renderer* r, const Game* g); // after each turn: waits out the turn rate, then render_frame
+
+#endif
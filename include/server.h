@@ -0,0 +1,36 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include "game.h"
+
+// Game server: many concurrent headless games in one process, one per client connection on a local
+// (Unix domain) stream socket, driven by a single epoll loop. Sessions come from a pool allocated up
+// front; every tick each session plays up to turnsPerTick of the turns its client asked for, and the
+// results are streamed back as text lines. Boards are shared between sessions through a BoardCache.
+//
+// Client -> server, one command per line:
+//   NEW <seed> [players]   start a game (a new one replaces the session's current game)
+//   RUN <turns>            play up to that many more turns
+//   QUIT                   close the session
+// Server -> client:
+//   OK <session>                       NEW accepted
+//   T <round> <player> <inMaze> <floor> <x> <y> <mp>   after each turn
+//   R <round>                          after each round end
+//   E <result> <rounds>                game over: winner id or a GameResult
+//   ERR <message>
+typedef struct {
+    const char* socketPath;
+    int sessions;          // pool size (connections served at once)
+    int tickMs;            // scheduling period
+    int turnsPerTick;      // per session per tick
+    int maxRounds;         // per game
+    const Maze* layout;    // NULL = built-in board
+    int players;           // player storage reserved per session up front; a larger NEW grows that session's once
+} ServerOptions;
+
+#define SERVER_DEFAULT_SESSIONS 1024
+#define SERVER_DEFAULT_TICK_MS 1
+#define SERVER_DEFAULT_TURNS_PER_TICK 64
+
+int server_run(const ServerOptions* opt); // until SIGINT/SIGTERM; 0 on a clean shutdown
+
+#endif
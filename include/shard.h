@@ -0,0 +1,29 @@
+#ifndef SHARD_H
+#define SHARD_H
+#include "sweep.h"
+
+// Multi-process sweep for very long runs: forked workers claim chunks of seeds from a table in shared
+// memory, play each chunk with sweep_run and add its stats to the table's totals with atomic adds
+// (no locks between processes). The coordinator saves the totals with the bitmap of finished chunks
+// every few seconds, so a run that is killed resumes from its last save and replays only the chunks
+// that were in flight. The save file is only valid for the same range, chunk size, players, round
+// cap and layout.
+typedef struct {
+    unsigned fromSeed, toSeed; // inclusive
+    int procs;                 // worker processes, <=0 picks the number of online CPUs
+    unsigned chunk;            // seeds per claim, 0 picks SHARD_DEFAULT_CHUNK
+    int maxRounds, players;
+    const Maze* layout;        // NULL = built-in board
+    bool batch;                // lockstep engine inside each worker
+    const char* savePath;      // progress file, NULL = no resume
+    int saveSeconds;           // between saves, <=0 picks SHARD_DEFAULT_SAVE_SECONDS
+} ShardOptions;
+
+#define SHARD_DEFAULT_CHUNK 4096
+#define SHARD_DEFAULT_SAVE_SECONDS 10
+
+// 0 when every chunk is done, 1 when stopped early (SIGINT/SIGTERM: saved, resumable), -1 on error;
+// out holds the totals so far either way
+int shard_run(const ShardOptions* opt, SweepStats* out);
+
+#endif
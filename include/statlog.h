@@ -0,0 +1,96 @@
+#ifndef STATLOG_H
+#define STATLOG_H
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "game.h"
+
+// Columnar stats file: header | table schemas | row groups. A group is {table, rows} followed by each
+// column of that table as rows fixed-width values, every column padded to 8 bytes. Each writer (one
+// per thread) fills its own groups and writes a full one with a single fwrite, so several writers can
+// share a file; across writers the rows of a table are in no particular order. Host byte order.
+#define STATLOG_MAGIC "MZSTATS\n"
+#define STATLOG_VERSION 1u
+#define STATLOG_GROUP_ROWS 16384u
+#define STATLOG_MAX_COLUMNS 12
+
+typedef enum { STAT_U8, STAT_U16, STAT_U32, STAT_I32 } StatType;
+
+typedef enum {
+    STATLOG_GAMES,   // one row per game
+    STATLOG_PLAYERS, // one row per player per game
+    STATLOG_ROUNDS,  // one row per player at the end of every round (optional)
+    STATLOG_TABLES
+} StatTableId;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t tables;
+} StatLogHeader;
+
+typedef struct {
+    char name[16];
+    uint32_t columns; // StatLogColumn entries that follow
+    uint32_t reserved;
+} StatLogTable;
+
+typedef struct {
+    char name[23];
+    uint8_t type; // StatType
+} StatLogColumn;
+
+typedef struct {
+    uint32_t table; // StatTableId
+    uint32_t rows;
+} StatLogGroup;
+
+typedef struct {
+    FILE* f;
+    pthread_mutex_t mu; // serializes group writes
+    bool failed;
+} StatLogFile;
+
+// Per-thread writer; with round rows it is also a GameEventSink that forwards to an optional next sink
+typedef struct {
+    StatLogFile* file;
+    StatLogGroup* group[STATLOG_TABLES]; // group header followed by the column buffers; NULL = table off
+    uint8_t* column[STATLOG_TABLES][STATLOG_MAX_COLUMNS];
+    const Game* game; // game whose rounds are recorded
+    GameEventSink next;
+    void* nextUser;
+} StatLog;
+
+int  statlog_file_open(StatLogFile* sf, const char* path); // 0 on success
+int  statlog_file_close(StatLogFile* sf);                  // 0 if every write succeeded
+int  statlog_init(StatLog* log, StatLogFile* sf, bool rounds); // 0 on success
+void statlog_free(StatLog* log); // flushes
+int  statlog_flush(StatLog* log);
+void statlog_add_game(StatLog* log, const Game* g, int winner); // games row plus a players row per player
+void statlog_attach(StatLog* log, Game* g); // round rows from the game's ROUND events; chains its current sink
+
+int statlog_type_width(StatType t);
+const char* statlog_table_name(StatTableId t);
+const StatLogColumn* statlog_table_columns(StatTableId t, int* count);
+
+// Mapped (read-only) view of a stats file and a walk over its row groups
+typedef struct {
+    void* base;
+    size_t size;
+    size_t dataOffset; // first group
+    int columns[STATLOG_TABLES];
+    const StatLogColumn* column[STATLOG_TABLES]; // schemas as stored in the file
+} StatLogMap;
+
+typedef struct {
+    StatTableId table;
+    uint32_t rows;
+    const uint8_t* column[STATLOG_MAX_COLUMNS];
+} StatLogView;
+
+int  statlog_map(StatLogMap* m, const char* path); // 0 on success
+void statlog_unmap(StatLogMap* m);
+bool statlog_next_group(const StatLogMap* m, size_t* offset, StatLogView* v); // offset starts at m->dataOffset; false at end
+int64_t statlog_value(const StatLogMap* m, const StatLogView* v, int col, uint32_t row);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include <stdio.h>
+#include "game.h"
+
+// Headless seed sweep: runs one independent Game per seed across worker threads
+typedef struct {
+    unsigned fromSeed, toSeed; // inclusive range
+    int threads;               // <=0 picks number of online CPUs
+    int maxRounds;             // safety cap per game (main.c uses 200000)
+    const char* eventLogPath;  // binary event log of every game (one stream per worker), NULL = none
+    const Maze* layout;        // parsed maze description shared by every seed, NULL = built-in board
+    bool batch;                // lockstep GameBatch engine per worker (not with an event log, which needs sinks)
+    int players;               // players per game, 1..GAME_MAX_PLAYERS
+    const char* statsPath;     // columnar stats file (StatLog: games and players tables), NULL = none
+    bool statsRounds;          // also its per-round table (needs sinks, so not with batch)
+    unsigned boards;           // >0: seed s plays board seed fromSeed + (s-fromSeed)%boards, dice seed s; 0 = board seed s
+    int boardCache;            // boards kept generated when they repeat, <=0 picks SWEEP_BOARD_CACHE
+    const GameConfig* config;  // rules of every game, NULL = the defaults of game_init_from_board
+} SweepOptions;
+
+#define SWEEP_BOARD_CACHE 64
+
+typedef struct {
+    int players; // entries in use in the per-player arrays
+    unsigned long long games;
+    unsigned long long wins[GAME_MAX_PLAYERS];
+    unsigned long long unfinished;      // no flag capture: stopped early or hit maxRounds
+    unsigned long long unwinnable;      // of those, stopped with GAME_RESULT_UNWINNABLE
+    unsigned long long stalled;         // of those, stopped with GAME_RESULT_STALLED
+    unsigned long long totalRounds;
+    double roundsSquared;               // sum of squared game lengths (their variance, for tune)
+    unsigned long long finishedRounds;  // rounds summed over games with a winner
+    int minRounds, maxRounds;           // over games with a winner
+    // Per-player sums of Player stats
+    unsigned long long stepsMoved[GAME_MAX_PLAYERS];
+    unsigned long long capturesDone[GAME_MAX_PLAYERS];
+    unsigned long long timesCaptured[GAME_MAX_PLAYERS];
+    unsigned long long stairsUsed[GAME_MAX_PLAYERS];
+    unsigned long long polesUsed[GAME_MAX_PLAYERS];
+    unsigned long long bawanaVisits[GAME_MAX_PLAYERS];
+} SweepStats;
+
+int  sweep_default_threads(void);
+void sweep_stats_add_game(SweepStats* s, const Game* g, int winner);
+void sweep_stats_merge(SweepStats* dst, const SweepStats* src);
+int  sweep_run(const SweepOptions* opt, SweepStats* out); // 0 on success; -1 also when a seed could not be played (out has the rest)
+void sweep_print(const SweepStats* s, FILE* out);
+
+#endif
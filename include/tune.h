@@ -0,0 +1,61 @@
+#ifndef TUNE_H
+#define TUNE_H
+#include <stdio.h>
+#include "sweep.h"
+
+// Adaptive rule tuning: every configuration of a grid (GameConfig x effect quotas) is played in
+// rounds of batchGames games, game k of each configuration on seed fromSeed+k so they are compared
+// on the same boards and dice. After each round a configuration stops being sampled when the
+// confidence intervals of both objectives are tight enough, when another configuration is better on
+// one beyond the intervals and no worse beyond them on the other (dominated), or at maxGames.
+//   balance: max over players of |win share - 1/players| among games with a winner (0 = fair)
+//   length:  |mean rounds - targetRounds| over all games (targetRounds 0: shorter is better)
+#define TUNE_MAX_VALUES 16 // values per grid axis
+
+typedef struct {
+    int stairCycle[TUNE_MAX_VALUES]; int stairCycles;
+    int oneWay[2]; int oneWays;
+    int alternate[2]; int alternates;
+    int effects[TUNE_MAX_VALUES][4]; int effectCount; // effectPercent rows; 0 rows = the layout's own
+} TuneGrid;
+
+typedef struct {
+    unsigned fromSeed;
+    int threads, maxRounds, players;
+    const Maze* layout;     // NULL = built-in board
+    int batchGames;         // games per configuration per round
+    int minGames, maxGames; // per configuration
+    double z;               // normal quantile of the intervals (1.96 = 95%)
+    double balanceEps;      // tight: balance half-width at most this
+    double lengthEps;       // ... and length half-width at most this fraction of the mean
+    double targetRounds;
+} TuneOptions;
+
+typedef enum { TUNE_ACTIVE, TUNE_TIGHT, TUNE_DOMINATED, TUNE_EXHAUSTED } TuneState;
+
+typedef struct {
+    GameConfig config;
+    int effectPercent[4];
+    SweepStats stats;
+    double balance, balanceHalf;  // estimate and interval half-width
+    double rounds, roundsHalf;    // mean game length
+    double lengthLo, lengthHi;    // interval of the length objective
+    TuneState state;
+    int dominatedBy;              // index of the configuration that beat it, -1 = none
+} TuneResult;
+
+typedef struct {
+    TuneResult* result; // [count]
+    int count;
+    unsigned long long games;       // played in total
+    unsigned long long fixedGames;  // a fixed-size sweep: maxGames for every configuration
+    double targetRounds;
+} TuneReport;
+
+int  tune_parse_list(const char* s, int* out, int cap); // "3,5,8" -> count, -1 when malformed
+int  tune_parse_effects(const char* s, TuneGrid* g);    // "25/35/25/10,30/30/20/10" -> 0 on success
+int  tune_run(const TuneOptions* opt, const TuneGrid* grid, TuneReport* out); // 0 on success
+void tune_print(const TuneReport* r, FILE* out); // table, then the Pareto front of the estimates
+void tune_report_free(TuneReport* r);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef UTILS_H
+#define UTILS_H
+#include <stddef.h>
+
+// Read-only whole-file view: mmap on POSIX, 64-byte aligned heap copy on Windows
+int  util_map_file(const char* path, void** base, size_t* size); // 0 on success
+void util_unmap_file(void* base, size_t size);
+
+// Zeroed heap array for over-aligned types (Board: malloc/calloc only promise max_align_t); NULL on failure
+void* util_aligned_calloc(size_t count, size_t size, size_t align);
+void  util_aligned_free(void* p);
+
+#endif
@@ -0,0 +1,176 @@
+#include "ai.h"
+#include "sweep.h"
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#define AI_CANDIDATES 4 // N,E,S,W
+
+struct AiPool {
+    AiConfig cfg;
+    unsigned playerMask;
+    int threadCount;          // including the calling thread
+    pthread_t* threads;
+    Game* scratch;            // preallocated rollout Game per thread, reused for every rollout
+    int scratchCount;
+    Rng* streams;             // per-rollout dice streams, non-overlapping splits of one decision stream
+    pthread_mutex_t mu;
+    pthread_cond_t wake, done;
+    unsigned long generation; // bumped per decision to wake workers
+    int busy;
+    bool quit;
+    // Current decision
+    const Game* src;
+    PlayerId pid;
+    int moveDie;
+    double deadline;
+    int totalItems;
+    atomic_int nextItem;
+    atomic_int wins[AI_CANDIDATES], runs[AI_CANDIDATES];
+};
+
+typedef struct { AiPool* pool; int index; } AiWorkerArg;
+
+static double now_ms(void){
+    struct timespec ts; timespec_get(&ts,TIME_UTC);
+    return (double)ts.tv_sec*1000.0 + (double)ts.tv_nsec/1e6;
+}
+
+// One random continuation of the game (cloned into sim) with pid facing d; true if pid captures the flag
+static bool rollout_play(const AiPool* pool, Game* sim, Direction d, int k){
+    const Game* src=pool->src;
+    PlayerId pid=pool->pid;
+    game_set_sink(sim,NULL,NULL);
+    game_set_chooser(sim,NULL,NULL); // rollouts play dice only
+    sim->rng = pool->streams[k]; // rollout k shares its stream across candidates
+    sim->players[pid].dir=d;
+    if(game_resume_turn(sim,pid,pool->moveDie)) return true;
+    for(int p=pid+1;p<sim->playerCount;++p) if(game_take_turn(sim,(PlayerId)p)) return false;
+    sim->roundNumber++;
+    game_round_end(sim);
+    return game_play(sim,src->roundNumber+pool->cfg.horizonRounds)==(int)pid;
+}
+
+static bool rollout(const AiPool* pool, Game* sim, Direction d, int k){
+    if(game_clone(sim,pool->src)!=0) return false; // out of memory growing sim: scored as a loss
+    return rollout_play(pool,sim,d,k);
+}
+
+// Items are interleaved (rollout-major) so every candidate gets a fair share before the deadline
+static void run_items(AiPool* pool, Game* sim){
+    for(;;){
+        if(pool->deadline>0 && now_ms()>=pool->deadline) break;
+        int item = atomic_fetch_add(&pool->nextItem,1);
+        if(item>=pool->totalItems) break;
+        int cand = item % AI_CANDIDATES, k = item / AI_CANDIDATES;
+        if(rollout(pool,sim,(Direction)cand,k)) atomic_fetch_add(&pool->wins[cand],1);
+        atomic_fetch_add(&pool->runs[cand],1);
+    }
+}
+
+static void* ai_worker(void* arg){
+    AiWorkerArg* wa=arg;
+    AiPool* pool=wa->pool;
+    Game* sim=&pool->scratch[wa->index];
+    unsigned long seen=0;
+    free(wa);
+    pthread_mutex_lock(&pool->mu);
+    for(;;){
+        while(!pool->quit && pool->generation==seen) pthread_cond_wait(&pool->wake,&pool->mu);
+        if(pool->quit) break;
+        seen=pool->generation;
+        pthread_mutex_unlock(&pool->mu);
+        run_items(pool,sim);
+        pthread_mutex_lock(&pool->mu);
+        if(--pool->busy==0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mu);
+    return NULL;
+}
+
+AiPool* ai_pool_create(const AiConfig* cfg){
+    AiPool* pool=calloc(1,sizeof *pool);
+    if(!pool) return NULL;
+    pool->cfg=*cfg;
+    if(pool->cfg.rollouts<1) pool->cfg.rollouts=1;
+    if(pool->cfg.horizonRounds<1) pool->cfg.horizonRounds=1;
+    int threads = cfg->threads>0 ? cfg->threads : sweep_default_threads();
+    pool->scratch=calloc((size_t)threads,sizeof(Game));
+    pool->threads=calloc((size_t)threads,sizeof(pthread_t));
+    pool->streams=malloc(sizeof(Rng)*(size_t)pool->cfg.rollouts);
+    bool reserved=pool->scratch!=NULL;
+    for(int t=0;reserved && t<threads;++t) reserved=game_reserve(&pool->scratch[t],cfg->players)==0;
+    if(!reserved || !pool->threads || !pool->streams){
+        for(int t=0;pool->scratch && t<threads;++t) game_free(&pool->scratch[t]);
+        free(pool->scratch); free(pool->threads); free(pool->streams); free(pool); return NULL;
+    }
+    pool->scratchCount=threads;
+    pthread_mutex_init(&pool->mu,NULL);
+    pthread_cond_init(&pool->wake,NULL);
+    pthread_cond_init(&pool->done,NULL);
+    pool->threadCount=1;
+    for(int t=1;t<threads;++t){
+        AiWorkerArg* wa=malloc(sizeof *wa);
+        if(!wa) break;
+        wa->pool=pool; wa->index=t;
+        if(pthread_create(&pool->threads[t],NULL,ai_worker,wa)!=0){ free(wa); break; }
+        pool->threadCount=t+1;
+    }
+    return pool;
+}
+
+void ai_pool_destroy(AiPool* pool){
+    if(!pool) return;
+    pthread_mutex_lock(&pool->mu);
+    pool->quit=true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mu);
+    for(int t=1;t<pool->threadCount;++t) pthread_join(pool->threads[t],NULL);
+    pthread_mutex_destroy(&pool->mu);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    for(int t=0;t<pool->scratchCount;++t) game_free(&pool->scratch[t]);
+    free(pool->scratch); free(pool->threads); free(pool->streams); free(pool);
+}
+
+int ai_choose_direction(AiPool* pool, const Game* g, PlayerId pid, int moveDie){
+    pool->src=g; pool->pid=pid; pool->moveDie=moveDie;
+    pool->deadline = pool->cfg.budgetMs>0 ? now_ms()+pool->cfg.budgetMs : 0.0;
+    pool->totalItems = pool->cfg.rollouts*AI_CANDIDATES;
+    Rng peek=g->rng, base;
+    rng_seed(&base,rng_next64(&peek),RNG_STREAM_ROLLOUT); // deterministic per decision, game stream untouched
+    for(int k=0;k<pool->cfg.rollouts;++k) pool->streams[k]=rng_split(&base);
+    atomic_store(&pool->nextItem,0);
+    for(int c=0;c<AI_CANDIDATES;++c){ atomic_store(&pool->wins[c],0); atomic_store(&pool->runs[c],0); }
+    pthread_mutex_lock(&pool->mu);
+    pool->busy=pool->threadCount-1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mu);
+    run_items(pool,&pool->scratch[0]);
+    pthread_mutex_lock(&pool->mu);
+    while(pool->busy>0) pthread_cond_wait(&pool->done,&pool->mu);
+    pthread_mutex_unlock(&pool->mu);
+    // Best capture rate wins; ties (including all-zero) keep the current direction
+    const Direction current=g->players[pid].dir;
+    int best=(int)current; double bestRate=-1.0;
+    for(int c=0;c<AI_CANDIDATES;++c){
+        int runs=atomic_load(&pool->runs[c]);
+        if(!runs) continue;
+        double rate=(double)atomic_load(&pool->wins[c])/(double)runs;
+        if(rate>bestRate || (rate==bestRate && c==(int)current)){ best=c; bestRate=rate; }
+    }
+    return best;
+}
+
+static int ai_chooser(const Game* g, PlayerId pid, int moveDie, void* user){
+    AiPool* pool=user;
+    if(pid>=32 || !((pool->playerMask>>pid)&1u)) return -1;
+    return ai_choose_direction(pool,g,pid,moveDie);
+}
+
+void ai_attach(Game* g, AiPool* pool, unsigned playerMask){
+    pool->playerMask=playerMask;
+    game_set_chooser(g,ai_chooser,pool);
+}
@@ -0,0 +1,504 @@
+#include "analyze.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Stair states a round can see: the game's current bits until its next stair cycle, then the
+// up-only/down-only alternation of forceOneWay+alternateDirections (or every direction open when
+// the config toggles at random)
+enum { VAR_CURRENT, VAR_UP, VAR_DOWN, VAR_ALL, VAR_COUNT };
+
+enum { PATH_MOVED, PATH_BLOCKED, PATH_BAWANA, PATH_DEPLETED };
+
+#define AN_MP_MAX (1ll<<40) // clamp for the MP a route needs
+#define AN_MP_GRID 4        // grid points per octave above ANALYZE_MP_EXACT, up to INT32_MAX
+#define AN_POINTS (1+ANALYZE_MP_EXACT+AN_MP_GRID*(31-ANALYZE_MP_EXACT_BITS))
+#define AN_MASS_MIN 1e-18   // probability below this in one state is dropped (keeps denormals out)
+#define AN_THREADS 8        // workers for analyze_expected; each holds two full distributions
+
+// One die roll from a cell in a direction. The cells entered depend only on the stair state; MP
+// decides only whether the move ends early by depletion.
+typedef struct {
+    int32_t end;      // cell the move ends on; for PATH_BAWANA the interior cell landed on
+    uint8_t kind;     // PATH_MOVED, PATH_BLOCKED (the last step cost the 2 MP penalty) or PATH_BAWANA
+    uint8_t count;    // cells entered, each applying its effect in order
+    int32_t cells[6];
+} AnPath;
+
+typedef struct {
+    const Game* g;
+    const Maze* m;
+    int flagCell, entranceCell;
+    int cycle, firstCycle;  // stair cycle length, rounds left before the game's next cycle
+    bool firstUp, exact;    // mode of that next cycle; exact is false for random toggling
+    int timeSteps;          // rounds fold onto [0,timeSteps): firstCycle rounds, then the repeating part
+    int* valid; int validCount; // existing cells
+    uint64_t stairs[VAR_COUNT][2][GAME_STAIR_WORDS]; // up/down enable bits per variant
+    AnPath* paths;          // [VAR_COUNT][cellCount][direction][die face]
+} AnCtx;
+
+static size_t path_index(const AnCtx* c, int v, int cell, int dir, int die){ return (((size_t)v*c->m->cellCount+cell)*4+dir)*6+die-1; }
+
+static int time_next(const AnCtx* c, int t){ return t+1<c->timeSteps ? t+1 : c->firstCycle; }
+static int time_variant(const AnCtx* c, int t){
+    if(t<c->firstCycle) return VAR_CURRENT;
+    if(!c->exact) return VAR_ALL;
+    return (((t-c->firstCycle)/c->cycle==0)==c->firstUp) ? VAR_UP : VAR_DOWN;
+}
+static int time_of_round(const AnCtx* c, int r){
+    return r<c->firstCycle ? r : c->firstCycle + (r-c->firstCycle)%(c->timeSteps-c->firstCycle);
+}
+
+static int bawana_type(const Maze* m, int cell){
+    int f=cell/(m->width*m->length), x=cell/m->length%m->width, y=cell%m->length;
+    const BawanaRegion* b=&m->bawana;
+    return maze_is_bawana(m,f,x,y) ? m->bawanaTypes[(x-b->xMin)*(b->yMax-b->yMin+1)+(y-b->yMin)] : 4;
+}
+
+// Same precedence as resolve_stair_or_pole in game.c, against a variant's stair bits
+static void path_teleport(const AnCtx* c, int v, int* f, int* x, int* y){
+    const Maze* m=c->m;
+    const TeleportCell* tc=maze_find_teleport(m,maze_cell_index(m,*f,*x,*y));
+    if(!tc) return;
+    for(uint32_t k=0;k<tc->count;++k){
+        uint32_t code=m->teleportCodes[tc->first+k];
+        if(code<TELEPORT_POLE_BASE){
+            uint32_t i=code>>1;
+            const Stair* s=&m->stairs[i];
+            if(!((c->stairs[v][code&1u][i>>6]>>(i&63))&1u)) continue;
+            if(code&1u){ *f=s->startFloor; *x=s->startX; *y=s->startY; } else { *f=s->endFloor; *x=s->endX; *y=s->endY; }
+            return;
+        }
+        *f=m->poles[code-TELEPORT_POLE_BASE].toFloor;
+        return;
+    }
+}
+
+// perform_move without the MP bookkeeping
+static void path_build(const AnCtx* c, int v, int cell, int dir, int steps, AnPath* p){
+    const Maze* m=c->m;
+    int f=cell/(m->width*m->length), x=cell/m->length%m->width, y=cell%m->length;
+    p->kind=PATH_MOVED; p->count=0;
+    for(int i=0;i<steps;++i){
+        if(!(m->cells[maze_cell_index(m,f,x,y)]&(CELL_OPEN_N<<dir))){ p->kind=PATH_BLOCKED; break; }
+        x += (dir==DIR_S)-(dir==DIR_N); y += (dir==DIR_E)-(dir==DIR_W);
+        path_teleport(c,v,&f,&x,&y);
+        if(maze_is_bawana(m,f,x,y)){
+            int px=x+(dir==DIR_N)-(dir==DIR_S), py=y+(dir==DIR_W)-(dir==DIR_E);
+            if(!maze_is_bawana_entrance(m,f,px,py)){ x=px; y=py; p->kind=PATH_BLOCKED; break; }
+        }
+        p->cells[p->count++]=maze_cell_index(m,f,x,y);
+        if(maze_is_bawana(m,f,x,y)){ p->kind=PATH_BAWANA; break; }
+    }
+    p->end=maze_cell_index(m,f,x,y);
+}
+
+// Player.movementPoints is an int: large values wrap around exactly as in the engine (a wrapped
+// negative MP depletes or strands the player, a common way for seeds to never finish)
+static long long effect_apply(const Maze* m, int cell, long long mp){
+    const CellEffect* e=&m->effects[cell];
+    if(e->type==CELL_EFFECT_CONSUME) mp-=e->value;
+    else if(e->type==CELL_EFFECT_ADD) mp+=e->value;
+    else if(e->type==CELL_EFFECT_MULTIPLY) mp*=e->value;
+    return (int32_t)(uint32_t)mp;
+}
+
+// Smallest MP before the cell's effect that leaves at least need (>= 1) after it
+static long long effect_invert(const Maze* m, int cell, long long need){
+    const CellEffect* e=&m->effects[cell];
+    if(e->type==CELL_EFFECT_CONSUME) need+=e->value;
+    else if(e->type==CELL_EFFECT_ADD) need-=e->value;
+    else if(e->type==CELL_EFFECT_MULTIPLY) need=(need+e->value-1)/e->value;
+    return need<1 ? 1 : need<AN_MP_MAX ? need : AN_MP_MAX;
+}
+
+// Plays a path's MP changes for a player starting the move with mp > 0; returns the path's kind
+// or PATH_DEPLETED (mp is then the value that sent the player to Bawana)
+static int path_play(const Maze* m, const AnPath* p, long long* mp){
+    for(int i=0;i<p->count;++i) if((*mp=effect_apply(m,p->cells[i],*mp))<=0) return PATH_DEPLETED;
+    if(p->kind==PATH_BLOCKED) *mp-=2;
+    return p->kind;
+}
+
+// MP needed before the move to have at least need (>= 1) after it without depleting
+static long long path_need(const Maze* m, const AnPath* p, long long need){
+    if(p->kind==PATH_BLOCKED) need+=2;
+    for(int i=p->count-1;i>=0;--i) need=effect_invert(m,p->cells[i],need);
+    return need;
+}
+
+static void ctx_free(AnCtx* c){ free(c->valid); free(c->paths); }
+
+static int ctx_init(AnCtx* c, const Game* g){
+    const Maze* m=&g->board->maze;
+    memset(c,0,sizeof *c);
+    c->g=g; c->m=m;
+    c->flagCell=maze_cell_index(m,g->flagFloor,g->flagX,g->flagY);
+    c->entranceCell=maze_cell_index(m,m->bawana.floor,m->bawana.entranceX,m->bawana.entranceY);
+    c->cycle = g->config.stairCycleRounds>0 ? g->config.stairCycleRounds : 1;
+    c->firstCycle = g->stairDirectionChangeCountdown>0 ? g->stairDirectionChangeCountdown : 1;
+    c->firstUp = (g->totalStairCycles+1)%2==1;
+    c->exact = g->config.forceOneWay && g->config.alternateDirections;
+    c->timeSteps = c->firstCycle + (c->exact ? 2*c->cycle : 1);
+    memcpy(c->stairs[VAR_CURRENT][0],g->stairUp,sizeof g->stairUp);
+    memcpy(c->stairs[VAR_CURRENT][1],g->stairDown,sizeof g->stairDown);
+    for(int i=0;i<m->stairCount;++i){
+        uint64_t bit=1ull<<(i&63);
+        c->stairs[VAR_UP][0][i>>6]|=bit; c->stairs[VAR_DOWN][1][i>>6]|=bit;
+        c->stairs[VAR_ALL][0][i>>6]|=bit; c->stairs[VAR_ALL][1][i>>6]|=bit;
+    }
+    c->valid=malloc((size_t)m->cellCount*sizeof *c->valid);
+    c->paths=calloc((size_t)VAR_COUNT*m->cellCount*24,sizeof *c->paths);
+    if(!c->valid || !c->paths){ ctx_free(c); return -1; }
+    for(int i=0;i<m->cellCount;++i) if(m->cells[i]&CELL_VALID) c->valid[c->validCount++]=i;
+    for(int v=0;v<VAR_COUNT;++v) for(int k=0;k<c->validCount;++k) for(int d=0;d<4;++d) for(int die=1;die<=6;++die)
+        path_build(c,v,c->valid[k],d,die,&c->paths[path_index(c,v,c->valid[k],d,die)]);
+    return 0;
+}
+
+int analyze_reach(const Game* g, AnalyzeReachMap* out){
+    AnCtx c;
+    if(ctx_init(&c,g)!=0) return -1;
+    const Maze* m=c.m;
+    size_t states=(size_t)c.timeSteps*m->cellCount*16;
+    int* turns=malloc(states*sizeof *turns);
+    long long* need=malloc(states*sizeof *need);
+    memset(out,0,sizeof *out);
+    out->cellTurns=malloc((size_t)m->cellCount*sizeof *out->cellTurns);
+    if(!turns || !need || !out->cellTurns){ free(turns); free(need); analyze_reach_free(out); ctx_free(&c); return -1; }
+    #define STATE(t,cell,d,ph) ((((size_t)(t)*m->cellCount+(cell))*4+(d))*4+(ph))
+    for(size_t i=0;i<states;++i){ turns[i]=-1; need[i]=0; }
+    // Standing on the flag at the start of a turn captures it before moving
+    for(int t=0;t<c.timeSteps;++t) for(int s=0;s<16;++s){ turns[STATE(t,c.flagCell,0,0)+s]=1; need[STATE(t,c.flagCell,0,0)+s]=1; }
+
+    // Bellman sweeps in place over (turns, need) ordered lexicographically; values only ever improve
+    for(bool changed=true;changed;){
+        changed=false;
+        for(int t=0;t<c.timeSteps;++t){
+            int v=time_variant(&c,t), tn=time_next(&c,t);
+            for(int k=0;k<c.validCount;++k){
+                int cell=c.valid[k];
+                if(cell==c.flagCell) continue;
+                for(int d=0;d<4;++d) for(int ph=0;ph<4;++ph){
+                    size_t s=STATE(t,cell,d,ph);
+                    int bestTurns=turns[s]; long long bestNeed=need[s];
+                    int dFrom = ph==0 ? 0 : d, dTo = ph==0 ? 3 : d; // the direction die can pick any direction
+                    for(int nd=dFrom;nd<=dTo;++nd) for(int die=1;die<=6;++die){
+                        const AnPath* p=&c.paths[path_index(&c,v,cell,nd,die)];
+                        int end=p->end, endDir=nd; long long bonus=0;
+                        if(p->kind==PATH_BAWANA){
+                            int type=bawana_type(m,end);
+                            if(type==3) bonus=200; else if(type==4) bonus=10; else continue; // Happy, worst Random MP
+                            end=c.entranceCell; endDir=DIR_N;
+                        }
+                        int ct; long long cn;
+                        if(end==c.flagCell){ ct=1; cn=1; }
+                        else {
+                            size_t n=STATE(tn,end,endDir,(ph+1)&3);
+                            if(turns[n]<0) continue;
+                            ct=turns[n]+1; cn=need[n];
+                        }
+                        cn = cn-bonus>1 ? cn-bonus : 1;
+                        cn=path_need(m,p,cn);
+                        if(bestTurns<0 || ct<bestTurns || (ct==bestTurns && cn<bestNeed)){ bestTurns=ct; bestNeed=cn; }
+                    }
+                    if(bestTurns!=turns[s] || bestNeed!=need[s]){ turns[s]=bestTurns; need[s]=bestNeed; changed=true; }
+                }
+            }
+        }
+    }
+
+    out->cellCount=m->cellCount;
+    out->exactStairs=c.exact;
+    for(int i=0;i<m->cellCount;++i) out->cellTurns[i]=-1;
+    for(int t=0;t<c.timeSteps;++t) for(int k=0;k<c.validCount;++k) for(int s=0;s<16;++s){
+        int cell=c.valid[k], tt=turns[STATE(t,cell,0,0)+s];
+        if(tt>=0 && (out->cellTurns[cell]<0 || tt<out->cellTurns[cell])) out->cellTurns[cell]=tt;
+    }
+    out->cellTurns[c.flagCell]=0;
+    // From the starting area: wait k rounds for a 6, enter (facing the start direction, die phase 1), go on
+    out->players=g->playerCount;
+    for(int i=0;i<g->playerCount;++i){
+        const MazeStart* st=&m->starts[i % m->startCount];
+        int entry=maze_cell_index(m,st->floor,st->entryX,st->entryY);
+        AnalyzeReach best={-1,0};
+        if(entry==c.flagCell) best=(AnalyzeReach){1,0};
+        else for(int k=0;k<c.timeSteps;++k){
+            size_t n=STATE(time_of_round(&c,k+1),entry,st->dir,1);
+            if(turns[n]<0) continue;
+            int ct=k+1+turns[n];
+            if(best.turns<0 || ct<best.turns || (ct==best.turns && need[n]<best.mp)) best=(AnalyzeReach){ct,need[n]};
+        }
+        out->start[i]=best;
+    }
+    #undef STATE
+    free(turns); free(need); ctx_free(&c);
+    return 0;
+}
+
+void analyze_reach_free(AnalyzeReachMap* r){ free(r->cellTurns); r->cellTurns=NULL; }
+
+// Distribution of one player over the states of a round. MP lives on a grid of points; a value
+// between two points is split between them in proportion, so the mean stays exact under the affine
+// cell effects while small values (the ones that can reach 0) stay exact.
+typedef struct { uint8_t kind, lo; uint16_t up; } AnStep; // mass goes to points lo and lo+1 (share up/65536)
+
+// Read-only data shared by the per-player runs
+typedef struct {
+    const AnCtx* c;
+    long long point[AN_POINTS]; // MP value of each grid point; point 0 stands for MP <= 0
+    AnStep* table;              // [path][point] outcome of the path from each point, for the variants in use
+    int typeCount[5];           // Bawana interior cells per effect type
+    int horizon;
+} AnGrid;
+
+// One worker: players first, first+step, ... below count run one after another on its buffers
+typedef struct {
+    const AnGrid* grid;
+    int first, step, count;
+    float* cur;   // [cell][direction][phase][point]; probabilities (float halves the memory traffic)
+    float* next;  // zero except for what this round has written
+    uint8_t* curLive;  // [cell] 1 when the cell's rows in cur may hold mass
+    uint8_t* nextLive;
+    double poison[2][3][4][AN_POINTS]; // [cur/next][skip turns left-1][phase][point]; position is irrelevant
+    double waiting, captured, stuck;
+    double* surv;      // [count][horizon+1] P(player not captured before round k); shared by the workers
+    AnalyzeOdds* odds; // [count], shared
+} AnRun;
+
+static AnStep grid_split(const AnGrid* gr, int kind, long long mp){
+    if(mp<=0) return (AnStep){ (uint8_t)kind, 0, 0 };
+    if(mp<=ANALYZE_MP_EXACT) return (AnStep){ (uint8_t)kind, (uint8_t)mp, 0 };
+    if(mp>=gr->point[AN_POINTS-1]) return (AnStep){ (uint8_t)kind, AN_POINTS-1, 0 };
+    int lo=ANALYZE_MP_EXACT, hi=AN_POINTS-1; // point[lo] <= mp < point[hi]
+    while(hi-lo>1){ int mid=(lo+hi)/2; if(gr->point[mid]<=mp) lo=mid; else hi=mid; }
+    long long a=gr->point[lo], b=gr->point[lo+1];
+    return (AnStep){ (uint8_t)kind, (uint8_t)lo, (uint16_t)((mp-a)*65536/(b-a)) };
+}
+
+static void run_add(float* dst, AnStep s, double p){
+    double up=p*s.up/65536;
+    dst[s.lo]+=(float)(p-up);
+    if(s.up) dst[s.lo+1]+=(float)up;
+}
+static void run_add_poison(double* dst, AnStep s, double p){
+    double up=p*s.up/65536;
+    dst[s.lo]+=p-up;
+    if(s.up) dst[s.lo+1]+=up;
+}
+
+// Mass ending a turn on cell: captured on the flag, stuck at MP <= 0, else kept for the next round
+static void run_land(AnRun* r, int cell, int dir, int ph, long long mp, double p){
+    if(cell==r->grid->c->flagCell) r->captured+=p;
+    else if(mp<=0) r->stuck+=p;
+    else { run_add(r->next+(((size_t)cell*4+dir)*4+ph)*AN_POINTS,grid_split(r->grid,0,mp),p); r->nextLive[cell]=1; }
+}
+
+// Random MP 10-100 at the Bawana entrance, facing north
+static void run_random_mp(AnRun* r, int ph, long long mp, double p){
+    int entrance=r->grid->c->entranceCell;
+    if(entrance==r->grid->c->flagCell || mp+10<=0 || mp+100>ANALYZE_MP_EXACT){
+        for(int u=10;u<=100;++u) run_land(r,entrance,DIR_N,ph,mp+u,p/91);
+        return;
+    }
+    float* dst=r->next+(((size_t)entrance*4+DIR_N)*4+ph)*AN_POINTS;
+    for(long long v=mp+10;v<=mp+100;++v) dst[v]+=(float)(p/91); // exact points
+    r->nextLive[entrance]=1;
+}
+
+// Bawana effect of type at the end of a move or a poisoning (mp already includes the cell effect)
+static void run_bawana(AnRun* r, int type, int cell, int ph, long long mp, double p){
+    int entrance=r->grid->c->entranceCell;
+    switch(type){
+        case 0: // Food Poisoning: three skipped turns in place
+            if(cell==r->grid->c->flagCell) r->captured+=p; else run_add_poison(r->poison[1][2][ph],grid_split(r->grid,0,mp),p);
+            break;
+        case 1: case 2: run_land(r,entrance,DIR_N,ph,mp+50,p); break;
+        case 3: run_land(r,entrance,DIR_N,ph,mp+200,p); break;
+        default: run_random_mp(r,ph,mp,p); break;
+    }
+}
+
+// Moves that deplete MP or land in Bawana, from grid point j
+static void run_rare(AnRun* r, const AnPath* p, int j, int ph, double mass){
+    const Maze* m=r->grid->c->m;
+    long long mp=r->grid->point[j];
+    if(path_play(m,p,&mp)==PATH_DEPLETED) run_bawana(r,bawana_type(m,r->grid->c->entranceCell),r->grid->c->entranceCell,ph,mp,mass);
+    else run_bawana(r,bawana_type(m,p->end),p->end,ph,mp,mass);
+}
+
+// Moves mass row (one cell, direction already settled) by each die face
+static void run_moves(AnRun* r, int v, int cell, int dir, int nph, const float* row){
+    const AnCtx* c=r->grid->c;
+    int live[AN_POINTS], n=0;
+    double total=0;
+    for(int j=1;j<AN_POINTS;++j) if(row[j]>AN_MASS_MIN){ live[n++]=j; total+=row[j]; }
+    if(!n) return;
+    if(cell==c->flagCell){ r->captured+=total; return; } // pre-move check
+    for(int die=1;die<=6;++die){
+        size_t pi=path_index(c,v,cell,dir,die);
+        const AnPath* p=&c->paths[pi];
+        const AnStep* tr=r->grid->table+pi*AN_POINTS;
+        float* dst=r->next+(((size_t)p->end*4+dir)*4+nph)*AN_POINTS;
+        bool onFlag = p->end==c->flagCell;
+        r->nextLive[p->end]=1;
+        for(int q=0;q<n;++q){
+            int j=live[q];
+            double mass=row[j]/6.0;
+            AnStep s=tr[j];
+            if(s.kind>=PATH_BAWANA) run_rare(r,p,j,nph,mass);
+            else if(!s.lo) r->stuck+=mass;
+            else if(onFlag) r->captured+=mass;
+            else run_add(dst,s,mass);
+        }
+    }
+}
+
+// One turn of the player in one round, for every state with mass
+static void run_round(AnRun* r, int v, int entry, int entryDir, long long entryMp){
+    const AnCtx* c=r->grid->c;
+    const Maze* m=c->m;
+    memset(r->poison[1],0,sizeof r->poison[1]);
+    if(r->waiting>0){
+        double enter=r->waiting/6;
+        r->waiting-=enter;
+        run_land(r,entry,entryDir,1,entryMp,enter);
+    }
+    // Skipped turns; the last one moves the player to a random interior cell and applies its effect
+    for(int k=0;k<3;++k) for(int ph=0;ph<4;++ph) for(int j=1;j<AN_POINTS;++j){
+        double p=r->poison[0][k][ph][j];
+        if(!p) continue;
+        if(k>0){ r->poison[1][k-1][ph][j]+=p; continue; }
+        for(int t=0;t<5;++t) if(r->grid->typeCount[t]) run_bawana(r,t,-1,ph,r->grid->point[j],p*r->grid->typeCount[t]/m->bawanaArea);
+    }
+    for(int k=0;k<c->validCount;++k){
+        int cell=c->valid[k];
+        if(!r->curLive[cell]) continue;
+        float* rows=r->cur+(size_t)cell*16*AN_POINTS; // [direction][phase][point]
+        // Phase 0 rolls the direction die: faces 2-5 pick N/E/S/W, 1 and 6 keep the direction
+        float turned[4][AN_POINTS];
+        for(int j=0;j<AN_POINTS;++j){
+            float any=(rows[j]+rows[4*AN_POINTS+j]+rows[8*AN_POINTS+j]+rows[12*AN_POINTS+j])/6;
+            for(int d=0;d<4;++d) turned[d][j]=any+rows[d*4*AN_POINTS+j]/3;
+        }
+        for(int d=0;d<4;++d){
+            run_moves(r,v,cell,d,1,turned[d]);
+            for(int ph=1;ph<4;++ph) run_moves(r,v,cell,d,(ph+1)&3,rows+(d*4+ph)*AN_POINTS);
+        }
+        memset(rows,0,16*AN_POINTS*sizeof *rows); // consumed; this buffer is next round's output
+        r->curLive[cell]=0;
+    }
+    float* t=r->cur; r->cur=r->next; r->next=t;
+    uint8_t* lt=r->curLive; r->curLive=r->nextLive; r->nextLive=lt;
+    memcpy(r->poison[0],r->poison[1],sizeof r->poison[0]);
+}
+
+static void run_player(AnRun* r, int player){
+    const AnGrid* gr=r->grid;
+    const AnCtx* c=gr->c;
+    const Maze* m=c->m;
+    const Game* g=c->g;
+    const Player* pl=&g->players[player];
+    const MazeStart* st=&m->starts[player % m->startCount];
+    double* surv=r->surv+(size_t)player*(gr->horizon+1);
+    long long mp=pl->movementPoints;
+    int ph=pl->movesSinceEntry&3;
+    r->waiting=r->captured=r->stuck=0;
+    memset(r->poison[0],0,sizeof r->poison[0]);
+    if(!pl->inMaze) r->waiting=1;
+    else if(pl->skipTurns>0 && pl->bawanaEffectType==0) run_add_poison(r->poison[0][pl->skipTurns>3 ? 2 : pl->skipTurns-1][ph],grid_split(gr,0,mp),1);
+    else if(mp<=0) r->stuck=1;
+    else {
+        int cell=maze_cell_index(m,pl->floor,pl->x,pl->y);
+        run_add(r->cur+(((size_t)cell*4+pl->dir)*4+ph)*AN_POINTS,grid_split(gr,0,mp),1);
+        r->curLive[cell]=1;
+    }
+    int entry=maze_cell_index(m,st->floor,st->entryX,st->entryY);
+    int t=0, k=0;
+    surv[0]=1;
+    while(k<gr->horizon){
+        run_round(r,time_variant(c,t),entry,st->dir,mp);
+        t=time_next(c,t);
+        surv[++k]=1-r->captured;
+        if(1-r->captured-r->stuck<1e-12) break; // nothing left in play
+    }
+    for(int rest=k+1;rest<=gr->horizon;++rest) surv[rest]=surv[k];
+    AnalyzeOdds* o=&r->odds[player];
+    *o=(AnalyzeOdds){ r->captured, r->stuck, 0 };
+    for(int q=0;q<gr->horizon;++q) o->rounds+=surv[q];
+    // Leave the buffers zeroed for the worker's next player
+    for(int i=0;i<c->validCount;++i){
+        int cell=c->valid[i];
+        if(r->curLive[cell]){ memset(r->cur+(size_t)cell*16*AN_POINTS,0,16*AN_POINTS*sizeof *r->cur); r->curLive[cell]=0; }
+    }
+}
+
+static void* run_players(void* arg){
+    AnRun* r=arg;
+    for(int i=r->first;i<r->count;i+=r->step) run_player(r,i);
+    return NULL;
+}
+
+// Each player's distribution is independent of the others; up to AN_THREADS workers share the players
+int analyze_expected(const Game* g, int horizon, AnalyzeExpected* out){
+    AnCtx c;
+    AnGrid gr={0};
+    AnRun runs[AN_THREADS]={0};
+    pthread_t tids[AN_THREADS];
+    if(horizon<1) horizon=1;
+    if(ctx_init(&c,g)!=0) return -1;
+    const Maze* m=c.m;
+    size_t rowCount=(size_t)m->cellCount*16, pathCount=(size_t)VAR_COUNT*m->cellCount*24;
+    int rc=0, players=g->playerCount, workers = players<AN_THREADS ? players : AN_THREADS;
+    double* surv=malloc((size_t)players*(horizon+1)*sizeof *surv);
+    AnalyzeOdds* odds=malloc((size_t)players*sizeof *odds);
+    gr.c=&c; gr.horizon=horizon;
+    gr.table=malloc(pathCount*AN_POINTS*sizeof *gr.table);
+    for(int i=0;i<workers;++i){
+        runs[i]=(AnRun){ .grid=&gr, .first=i, .step=workers, .count=players, .surv=surv, .odds=odds };
+        runs[i].cur=calloc(rowCount*AN_POINTS,sizeof *runs[i].cur);
+        runs[i].next=calloc(rowCount*AN_POINTS,sizeof *runs[i].next);
+        runs[i].curLive=calloc((size_t)m->cellCount,1);
+        runs[i].nextLive=calloc((size_t)m->cellCount,1);
+        if(!runs[i].cur || !runs[i].next || !runs[i].curLive || !runs[i].nextLive) rc=-1;
+    }
+    if(!gr.table || !surv || !odds) rc=-1;
+    if(rc==0){
+        for(int j=0;j<=ANALYZE_MP_EXACT;++j) gr.point[j]=j;
+        for(int j=ANALYZE_MP_EXACT+1;j<AN_POINTS;++j){
+            int k=j-ANALYZE_MP_EXACT; // k/AN_MP_GRID octaves above ANALYZE_MP_EXACT
+            gr.point[j] = k%AN_MP_GRID ? gr.point[j-1]*1189/1000 : gr.point[j-AN_MP_GRID]*2; // 2^(1/4) steps
+        }
+        gr.point[AN_POINTS-1]=INT32_MAX;
+        for(int i=0;i<m->bawanaArea;++i) gr.typeCount[m->bawanaTypes[i]]++;
+        // Outcome of every path from every point, for the stair variants this config can produce
+        for(int v=0;v<VAR_COUNT;++v){
+            if(v!=VAR_CURRENT && (v==VAR_ALL)==c.exact) continue;
+            for(int k=0;k<c.validCount;++k) for(int d=0;d<4;++d) for(int die=1;die<=6;++die){
+                size_t pi=path_index(&c,v,c.valid[k],d,die);
+                for(int j=1;j<AN_POINTS;++j){
+                    long long mp=gr.point[j];
+                    int kind=path_play(m,&c.paths[pi],&mp);
+                    gr.table[pi*AN_POINTS+j] = kind>=PATH_BAWANA ? (AnStep){ (uint8_t)kind, 0, 0 } : grid_split(&gr,kind,mp);
+                }
+            }
+        }
+        int started=0;
+        for(;started<workers;++started) if(pthread_create(&tids[started],NULL,run_players,&runs[started])!=0) break;
+        for(int i=started;i<workers;++i) run_players(&runs[i]);
+        for(int i=0;i<started;++i) pthread_join(tids[i],NULL);
+
+        memset(out,0,sizeof *out);
+        out->horizon=horizon;
+        out->players=players;
+        for(int i=0;i<players;++i) out->player[i]=odds[i];
+        for(int k=0;k<=horizon;++k){
+            double alive=1;
+            for(int i=0;i<players;++i) alive*=surv[(size_t)i*(horizon+1)+k];
+            if(k<horizon) out->gameRounds+=alive; else out->gameOver=1-alive;
+        }
+    }
+    for(int i=0;i<workers;++i){ free(runs[i].cur); free(runs[i].next); free(runs[i].curLive); free(runs[i].nextLive); }
+    free(surv); free(odds); free(gr.table); ctx_free(&c);
+    return rc;
+}
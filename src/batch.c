@@ -0,0 +1,364 @@
+#include "batch.h"
+#include <string.h>
+
+// Lane loops: the common path of every phase is straight-line arithmetic over [field][lane] arrays;
+// rare events (teleports, Bawana, captures, rejection redraws) drop to per-lane code that mirrors
+// the scalar rules in game.c line by line. Lane conditions are 0/1 int32 arrays so the lane loops
+// stay branch-free.
+
+static Rng lane_rng(const GameBatch* b, int l){ Rng r; for(int k=0;k<4;++k) r.s[k]=b->rng[k][l]; return r; }
+static void lane_rng_set(GameBatch* b, int l, const Rng* r){ for(int k=0;k<4;++k) b->rng[k][l]=r->s[k]; }
+
+static uint32_t lane_bounded(GameBatch* b, int l, uint32_t bound){
+    Rng r=lane_rng(b,l); uint32_t v=rng_bounded(&r,bound); lane_rng_set(b,l,&r); return v;
+}
+
+// One xoshiro128++ draw in every lane with on[l]==1; the other lanes keep their state
+static void batch_rng_next(GameBatch* b, const int32_t* on, uint32_t* out){
+    for(int l=0;l<BATCH_LANES;++l){
+        uint32_t s0=b->rng[0][l], s1=b->rng[1][l], s2=b->rng[2][l], s3=b->rng[3][l];
+        out[l] = rng_rotl(s0+s3,7)+s0;
+        uint32_t t=s1<<9;
+        uint32_t n2=s2^s0, n3=s3^s1;
+        uint32_t n1=s1^n2, n0=s0^n3;
+        n2^=t; n3=rng_rotl(n3,11);
+        uint32_t keep = 0u-(uint32_t)on[l]; // all ones in drawing lanes
+        b->rng[0][l]=(n0&keep)|(s0&~keep); b->rng[1][l]=(n1&keep)|(s1&~keep);
+        b->rng[2][l]=(n2&keep)|(s2&~keep); b->rng[3][l]=(n3&keep)|(s3&~keep);
+    }
+}
+
+// rng_bounded(bound) in every lane with on[l]==1; the rare rejection retries run per lane
+static void batch_rng_bounded(GameBatch* b, const int32_t* on, uint32_t bound, int32_t* out){
+    uint32_t r[BATCH_LANES];
+    int32_t low=0;
+    batch_rng_next(b,on,r);
+    for(int l=0;l<BATCH_LANES;++l){
+        uint64_t m=(uint64_t)r[l]*bound;
+        out[l]=(int32_t)(m>>32);
+        low|=on[l]&((uint32_t)m<bound);
+    }
+    if(!low) return;
+    uint32_t threshold=(0u-bound)%bound;
+    for(int l=0;l<BATCH_LANES;++l){
+        uint64_t m=(uint64_t)r[l]*bound;
+        if(!on[l] || (uint32_t)m>=threshold) continue;
+        Rng rr=lane_rng(b,l);
+        do m=(uint64_t)rng_next(&rr)*bound; while((uint32_t)m<threshold);
+        lane_rng_set(b,l,&rr); out[l]=(int32_t)(m>>32);
+    }
+}
+
+static inline int32_t dir_delta(int32_t d, int32_t row){ return d==DIR_N ? -row : d==DIR_S ? row : d==DIR_E ? 1 : -1; }
+
+static int32_t floor_base(const GameBatch* b, int l, int32_t cell){ return cell - cell%b->floorSize[l]; }
+
+static void lane_end(GameBatch* b, int l, int result){ b->winner[l]=result; b->finished|=1u<<l; b->live[l]=0; }
+
+// assign_bawana_effect for player p of lane l
+static void lane_bawana_effect(GameBatch* b, int l, int p){
+    const Maze* m=&b->board[l]->maze;
+    const BawanaRegion* bw=&m->bawana;
+    int32_t c=b->cell[p][l];
+    int type=4; // fallback outside the region
+    if(b->cells[l][c]&CELL_BAWANA){
+        int x=(c%b->floorSize[l])/b->rowStride[l], y=c%b->rowStride[l];
+        type=m->bawanaTypes[(x-bw->xMin)*(bw->yMax-bw->yMin+1)+(y-bw->yMin)];
+    }
+    b->bawanaEffectType[p][l]=type;
+    switch(type){
+        case 0: b->skipTurns[p][l]=3; b->bawanaEffectTurns[p][l]=3; break;
+        case 1: b->mp[p][l]+=50; b->randomDisoriented[p][l]=1; b->disorientedTurns[p][l]=4; break;
+        case 2: b->mp[p][l]+=50; b->triggered[p][l]=1; b->bawanaEffectTurns[p][l]=0; break;
+        case 3: b->mp[p][l]+=200; break;
+        case 4: b->mp[p][l]+=(int32_t)lane_bounded(b,l,91)+10; break;
+    }
+    if(type!=0){ b->cell[p][l]=b->entranceCell[l]; b->dir[p][l]=DIR_N; }
+}
+
+static void lane_send_to_bawana(GameBatch* b, int l, int p){
+    b->cell[p][l]=b->entranceCell[l]; b->dir[p][l]=DIR_N; b->randomDisoriented[p][l]=0; b->triggered[p][l]=0;
+    b->disorientedTurns[p][l]=0; b->bawanaEffectType[p][l]=-1; b->bawanaEffectTurns[p][l]=0;
+}
+
+// resolve_stair_or_pole for a player standing on cell c (a CELL_TELEPORT cell); returns the new cell
+static int32_t lane_teleport(GameBatch* b, int l, int p, int32_t c){
+    const Maze* m=&b->board[l]->maze;
+    const TeleportCell* tc=maze_find_teleport(m,c);
+    if(!tc) return c;
+    for(uint32_t k=0;k<tc->count;++k){
+        uint32_t code=m->teleportCodes[tc->first+k];
+        if(code<TELEPORT_POLE_BASE){
+            uint32_t i=code>>1;
+            const Stair* s=&m->stairs[i];
+            if(code&1u){
+                if(!((b->stairDown[i>>6][l]>>(i&63))&1u)) continue;
+                c=maze_cell_index(m,s->startFloor,s->startX,s->startY);
+            } else {
+                if(!((b->stairUp[i>>6][l]>>(i&63))&1u)) continue;
+                c=maze_cell_index(m,s->endFloor,s->endX,s->endY);
+            }
+            b->stairsUsed[p][l]++;
+            return c;
+        }
+        b->polesUsed[p][l]++;
+        return c%b->floorSize[l] + m->poles[code-TELEPORT_POLE_BASE].toFloor*b->floorSize[l];
+    }
+    return c;
+}
+
+// Rest of a step that landed on a teleport or Bawana cell; false when the move ends here
+static bool lane_step_rare(GameBatch* b, int l, int p){
+    int32_t c=b->cell[p][l];
+    if(b->cells[l][c]&CELL_TELEPORT) c=b->cell[p][l]=lane_teleport(b,l,p,c);
+    bool inBawana=(b->cells[l][c]&CELL_BAWANA)!=0;
+    if(inBawana){
+        // Interior is entered only from the entrance cell; anything else bounces back with the penalty
+        int32_t prev=c-dir_delta(b->dir[p][l],b->rowStride[l]);
+        if(prev!=b->entranceCell[l]){ b->cell[p][l]=prev; b->mp[p][l]-=2; return false; }
+    }
+    b->mp[p][l]=maze_effect_apply(b->mp[p][l],b->effects[l][c]);
+    if(b->mp[p][l]<=0){ lane_send_to_bawana(b,l,p); lane_bawana_effect(b,l,p); return false; }
+    if(inBawana){ b->bawanaVisits[p][l]++; lane_bawana_effect(b,l,p); return false; }
+    return true;
+}
+
+// perform_move of player p in every lane with moving[l]==1. Each pass advances every moving lane one
+// step without branching on the lane's outcome; lanes that stop drop out of the compacted lane list,
+// and lanes that landed on a teleport/Bawana cell or ran out of MP finish the step per lane.
+static void batch_move(GameBatch* b, int p, const int32_t* moving, int32_t* left){
+    int32_t* cell=b->cell[p]; int32_t* mp=b->mp[p]; const int32_t* dir=b->dir[p];
+    uint32_t* steps=b->stepsMoved[p];
+    int lanes[BATCH_LANES], n=0;
+    for(int l=0;l<BATCH_LANES;++l){ lanes[n]=l; n+=moving[l]; }
+    while(n){
+        int next[BATCH_LANES], rare[BATCH_LANES], kept=0, slow=0;
+        for(int k=0;k<n;++k){
+            int l=lanes[k];
+            int32_t c=cell[l], d=dir[l], m=mp[l];
+            const uint8_t* cells=b->cells[l];
+            int32_t go = m>0;
+            int32_t open = go & (int32_t)((cells[c]>>d)&1u); // wall, edge or missing cell otherwise
+            int32_t nc = c + (open ? dir_delta(d,b->rowStride[l]) : 0);
+            int32_t odd = open & ((cells[nc]&(CELL_TELEPORT|CELL_BAWANA))!=0);
+            int32_t m2 = maze_effect_apply(m,b->effects[l][nc]);
+            int32_t plain = open & !odd;
+            m = plain ? m2 : (go & !open) ? m-2 : m;
+            int32_t depleted = plain & (m<=0);
+            cell[l]=nc; mp[l]=m; steps[l]+=(uint32_t)open; left[l]-=plain;
+            rare[slow]=l; slow+=odd|depleted;
+            next[kept]=l; kept+=plain & !depleted & (left[l]>0);
+        }
+        for(int k=0;k<slow;++k){
+            int l=rare[k];
+            if(mp[l]<=0 && !(b->cells[l][cell[l]]&(CELL_TELEPORT|CELL_BAWANA))){ lane_send_to_bawana(b,l,p); lane_bawana_effect(b,l,p); continue; }
+            if(lane_step_rare(b,l,p) && --left[l]>0) next[kept++]=l;
+        }
+        memcpy(lanes,next,sizeof(int)*(size_t)kept); n=kept;
+    }
+}
+
+// One turn of player p in every unfinished lane (game_take_turn + game_resume_turn). The common
+// outcomes are computed for all lanes as 0/1 lane flags; entries, wins and captures follow per lane.
+static void batch_turn(GameBatch* b, int p){
+    int32_t roll[BATCH_LANES], poison[BATCH_LANES], turnDir[BATCH_LANES], enter[BATCH_LANES], early[BATCH_LANES];
+    int32_t move[BATCH_LANES], confused[BATCH_LANES], left[BATCH_LANES], die[BATCH_LANES], face[BATCH_LANES];
+    int32_t anyPoison=0, anyRoll=0;
+    for(int l=0;l<BATCH_LANES;++l){
+        int32_t on=b->live[l], d=b->disorientedTurns[p][l];
+        b->disorientedTurns[p][l] = d - (on & (d>0));
+        b->randomDisoriented[p][l] &= !(on & (d==1));
+        int32_t skip = on & (b->skipTurns[p][l]>0);
+        b->skipTurns[p][l] -= skip;
+        poison[l] = skip & (b->skipTurns[p][l]==0) & (b->bawanaEffectType[p][l]==0);
+        roll[l] = on & !skip;
+        anyPoison|=poison[l]; anyRoll|=roll[l];
+    }
+    if(anyPoison) for(int l=0;l<BATCH_LANES;++l){
+        if(!poison[l]) continue;
+        // Poisoning over: random interior cell, and its effect right away
+        const BawanaRegion* bw=&b->board[l]->maze.bawana;
+        int rx=(int)lane_bounded(b,l,(uint32_t)(bw->xMax-bw->xMin+1))+bw->xMin;
+        int ry=(int)lane_bounded(b,l,(uint32_t)(bw->yMax-bw->yMin+1))+bw->yMin;
+        b->cell[p][l]=maze_cell_index(&b->board[l]->maze,bw->floor,rx,ry);
+        lane_bawana_effect(b,l,p);
+    }
+    if(!anyRoll) return;
+    batch_rng_bounded(b,roll,6,die);
+    int32_t anyDir=0;
+    for(int l=0;l<BATCH_LANES;++l){
+        int32_t n=b->movesSinceEntry[p][l];
+        turnDir[l] = roll[l] & b->inMaze[p][l] & (n>0) & ((n&3)==0);
+        anyDir|=turnDir[l];
+    }
+    if(anyDir){
+        batch_rng_bounded(b,turnDir,6,face);
+        for(int l=0;l<BATCH_LANES;++l) // faces 2..5 = N,E,S,W, the rest keep the direction
+            b->dir[p][l] = (turnDir[l] & (face[l]>=1) & (face[l]<=4)) ? face[l]-1 : b->dir[p][l];
+    }
+    int32_t anyEnter=0, anyEarly=0, anyMove=0, anyConfused=0;
+    for(int l=0;l<BATCH_LANES;++l){
+        int32_t r=roll[l], inMaze=b->inMaze[p][l];
+        b->directionRollCounter[p][l]+=r;
+        enter[l] = r & !inMaze & (die[l]==5); // a 6 enters the maze
+        int32_t stay = r & inMaze;
+        b->movesSinceEntry[p][l]+=stay;
+        early[l] = stay & (b->cell[p][l]==b->flagCell[l]); // already on the flag
+        move[l] = stay & !early[l];
+        left[l] = move[l]*(die[l]+1)*(1+b->triggered[p][l]); // triggered players move double
+        confused[l] = move[l] & b->randomDisoriented[p][l];
+        anyEnter|=enter[l]; anyEarly|=early[l]; anyMove|=move[l]; anyConfused|=confused[l];
+    }
+    if(anyEnter) for(int l=0;l<BATCH_LANES;++l){
+        if(!enter[l]) continue;
+        const Maze* m=&b->board[l]->maze;
+        const MazeStart* s=&m->starts[p % m->startCount];
+        b->cell[p][l]=floor_base(b,l,b->cell[p][l])+s->entryX*b->rowStride[l]+s->entryY;
+        b->inMaze[p][l]=1; b->movesSinceEntry[p][l]=1;
+        if(b->cell[p][l]==b->flagCell[l]) lane_end(b,l,p);
+    }
+    if(anyEarly) for(int l=0;l<BATCH_LANES;++l) if(early[l]) lane_end(b,l,p);
+    if(!anyMove) return;
+    if(anyConfused){
+        batch_rng_bounded(b,confused,4,face);
+        for(int l=0;l<BATCH_LANES;++l) b->dir[p][l] = confused[l] ? face[l] : b->dir[p][l];
+    }
+    batch_move(b,p,move,left);
+    int32_t* after=early; // reused: lanes with a capture or the flag under the mover
+    int32_t anyAfter=0;
+    for(int l=0;l<BATCH_LANES;++l){
+        int32_t c=b->cell[p][l], hit=(c==b->flagCell[l]);
+        for(int i=0;i<b->playerCount;++i) hit |= (i!=p) & b->inMaze[i][l] & (b->cell[i][l]==c);
+        after[l]=move[l]&hit; anyAfter|=after[l];
+    }
+    if(anyAfter) for(int l=0;l<BATCH_LANES;++l){
+        if(!after[l]) continue;
+        int32_t c=b->cell[p][l];
+        for(int i=0;i<b->playerCount;++i){
+            if(i==p || !b->inMaze[i][l] || b->cell[i][l]!=c) continue;
+            // Captured: back to the starting area (floor unchanged, as in the scalar engine)
+            const Maze* m=&b->board[l]->maze;
+            const MazeStart* s=&m->starts[i % m->startCount];
+            b->capturesDone[p][l]++; b->timesCaptured[i][l]++;
+            b->cell[i][l]=floor_base(b,l,b->cell[i][l])+s->x*b->rowStride[l]+s->y;
+            b->inMaze[i][l]=0; b->dir[i][l]=s->dir;
+        }
+        if(c==b->flagCell[l]) lane_end(b,l,p);
+    }
+}
+
+// Stair cycle of game_round_end for lane l, once its countdown ran out
+static void lane_stair_cycle(GameBatch* b, int l){
+    const GameConfig* cfg=&b->config[l];
+    b->stairCountdown[l]=cfg->stairCycleRounds;
+    uint32_t cycles=++b->totalStairCycles[l];
+    Rng r=lane_rng(b,l);
+    bool upMode = cfg->alternateDirections ? (cycles%2)==1 : !rng_bit(&r);
+    for(int i=0;i<b->board[l]->maze.stairCount;++i){
+        uint64_t bit=1ull<<(i&63);
+        uint64_t* upWord=&b->stairUp[i>>6][l]; uint64_t* downWord=&b->stairDown[i>>6][l];
+        bool up, down;
+        if(cfg->forceOneWay){ up=upMode; down=!upMode; }
+        else if(!rng_bit(&r)){ up=true; down=true; }
+        else if(!rng_bit(&r)){ up=true; down=false; } else { up=false; down=true; }
+        *upWord = up ? (*upWord|bit) : (*upWord&~bit);
+        *downWord = down ? (*downWord|bit) : (*downWord&~bit);
+    }
+    lane_rng_set(b,l,&r);
+}
+
+// game_watch_check on lane l's state: same samples, game_stalled on the lane's players
+static int lane_watch(GameBatch* b, int l){
+    if(!b->flagReachable[l]) return GAME_RESULT_UNWINNABLE;
+    b->watchNext[l]=b->roundNumber[l]+GAME_WATCH_INTERVAL;
+    const Maze* m=&b->board[l]->maze;
+    int32_t flag=b->flagCell[l];
+    for(int i=0;i<b->playerCount;++i){
+        const MazeStart* s=&m->starts[i % m->startCount];
+        if(b->mp[i][l]>0 || b->skipTurns[i][l]>0 || (b->inMaze[i][l] && b->cell[i][l]==flag) ||
+           maze_cell_index(m,s->floor,s->entryX,s->entryY)==flag) return 0;
+    }
+    return GAME_RESULT_STALLED;
+}
+
+void batch_init(GameBatch* b){ memset(b,0,sizeof *b); }
+
+void batch_lane_load(GameBatch* b, int l, const Game* g){
+    const Maze* m=&g->board->maze;
+    b->playerCount=g->playerCount;
+    b->board[l]=g->board; b->cells[l]=m->cells; b->effects[l]=m->effects;
+    b->rowStride[l]=m->length; b->floorSize[l]=m->width*m->length;
+    b->entranceCell[l]=maze_cell_index(m,m->bawana.floor,m->bawana.entranceX,m->bawana.entranceY);
+    for(int k=0;k<4;++k) b->rng[k][l]=g->rng.s[k];
+    b->roundNumber[l]=g->roundNumber;
+    b->stairCountdown[l]=g->stairDirectionChangeCountdown; b->stairMode[l]=g->stairDirectionMode;
+    b->totalStairCycles[l]=g->totalStairCycles;
+    for(int w=0;w<GAME_STAIR_WORDS;++w){ b->stairUp[w][l]=g->stairUp[w]; b->stairDown[w][l]=g->stairDown[w]; }
+    b->flagCell[l]=maze_cell_index(m,g->flagFloor,g->flagX,g->flagY);
+    b->flagReachable[l]=game_flag_reachable(g);
+    b->watchNext[l]=g->roundNumber;
+    b->config[l]=g->config;
+    for(int i=0;i<b->playerCount;++i){
+        const Player* p=&g->players[i];
+        b->cell[i][l]=maze_cell_index(m,p->floor,p->x,p->y);
+        b->mp[i][l]=p->movementPoints; b->dir[i][l]=p->dir;
+        b->skipTurns[i][l]=p->skipTurns; b->disorientedTurns[i][l]=p->disorientedTurnsRemaining;
+        b->bawanaEffectType[i][l]=p->bawanaEffectType; b->bawanaEffectTurns[i][l]=p->bawanaEffectTurns;
+        b->inMaze[i][l]=p->inMaze; b->randomDisoriented[i][l]=p->randomDisoriented; b->triggered[i][l]=p->triggered;
+        b->directionRollCounter[i][l]=p->directionRollCounter; b->movesSinceEntry[i][l]=p->movesSinceEntry;
+        b->stepsMoved[i][l]=p->stepsMoved; b->capturesDone[i][l]=p->capturesDone; b->timesCaptured[i][l]=p->timesCaptured;
+        b->stairsUsed[i][l]=p->stairsUsed; b->polesUsed[i][l]=p->polesUsed; b->bawanaVisits[i][l]=p->bawanaVisits;
+    }
+    b->winner[l]=-1;
+    b->active|=1u<<l; b->finished&=~(1u<<l); b->live[l]=1;
+}
+
+void batch_lane_store(const GameBatch* b, int l, Game* g){
+    for(int k=0;k<4;++k) g->rng.s[k]=b->rng[k][l];
+    g->roundNumber=b->roundNumber[l];
+    g->stairDirectionChangeCountdown=b->stairCountdown[l]; g->stairDirectionMode=b->stairMode[l];
+    g->totalStairCycles=b->totalStairCycles[l];
+    for(int w=0;w<GAME_STAIR_WORDS;++w){ g->stairUp[w]=b->stairUp[w][l]; g->stairDown[w]=b->stairDown[w][l]; }
+    for(int i=0;i<b->playerCount;++i){
+        Player* p=&g->players[i];
+        int32_t c=b->cell[i][l];
+        p->floor=c/b->floorSize[l]; p->x=(c%b->floorSize[l])/b->rowStride[l]; p->y=c%b->rowStride[l];
+        p->movementPoints=b->mp[i][l]; p->dir=(Direction)b->dir[i][l];
+        p->skipTurns=b->skipTurns[i][l]; p->disorientedTurnsRemaining=b->disorientedTurns[i][l];
+        p->bawanaEffectType=b->bawanaEffectType[i][l]; p->bawanaEffectTurns=b->bawanaEffectTurns[i][l];
+        p->inMaze=b->inMaze[i][l]; p->randomDisoriented=b->randomDisoriented[i][l]; p->triggered=b->triggered[i][l];
+        p->directionRollCounter=b->directionRollCounter[i][l]; p->movesSinceEntry=b->movesSinceEntry[i][l];
+        p->stepsMoved=b->stepsMoved[i][l]; p->capturesDone=b->capturesDone[i][l]; p->timesCaptured=b->timesCaptured[i][l];
+        p->stairsUsed=b->stairsUsed[i][l]; p->polesUsed=b->polesUsed[i][l]; p->bawanaVisits=b->bawanaVisits[i][l];
+    }
+    game_reindex(g);
+}
+
+void batch_lane_clear(GameBatch* b, int l){ b->active&=~(1u<<l); b->finished&=~(1u<<l); b->live[l]=0; }
+
+uint32_t batch_run(GameBatch* b, int maxRounds){
+    uint32_t before=b->finished;
+    for(;;){
+        // Same cap check as game_play: before each round
+        int32_t any=0;
+        for(int l=0;l<BATCH_LANES;++l){
+            int32_t capped = b->live[l] & (b->roundNumber[l]>=maxRounds); // winner stays GAME_RESULT_CAPPED
+            b->finished|=(uint32_t)capped<<l; b->live[l]&=!capped;
+            // then the early-termination samples of game_play
+            int stop = b->live[l] && b->roundNumber[l]>=b->watchNext[l] ? lane_watch(b,l) : 0;
+            if(stop) lane_end(b,l,stop);
+            any|=b->live[l];
+        }
+        if(b->finished!=before || !any) break;
+        for(int p=0;p<b->playerCount;++p) batch_turn(b,p);
+        // game_round_end in every lane still playing
+        int32_t cycle[BATCH_LANES], anyCycle=0;
+        for(int l=0;l<BATCH_LANES;++l){
+            int32_t on=b->live[l];
+            b->roundNumber[l]+=on; b->stairCountdown[l]-=on;
+            cycle[l]=on & (b->stairCountdown[l]<=0); anyCycle|=cycle[l];
+        }
+        if(anyCycle) for(int l=0;l<BATCH_LANES;++l) if(cycle[l]) lane_stair_cycle(b,l);
+    }
+    return b->finished&~before;
+}
@@ -0,0 +1,113 @@
+#include "boardcache.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t seed_hash(unsigned seed){ uint32_t h=(uint32_t)seed*0x9e3779b1u; return h^(h>>16); }
+
+int board_cache_init(BoardCache* c, int capacity, const Maze* layout){
+    memset(c,0,sizeof *c);
+    if(capacity<1) capacity=1;
+    uint32_t buckets=1; while(buckets<2u*(uint32_t)capacity) buckets<<=1;
+    c->entry=util_aligned_calloc((size_t)capacity,sizeof *c->entry,_Alignof(BoardCacheEntry));
+    c->bucket=calloc(buckets,sizeof *c->bucket);
+    if(!c->entry || !c->bucket || pthread_mutex_init(&c->mu,NULL)!=0){ util_aligned_free(c->entry); free(c->bucket); return -1; }
+    if(pthread_cond_init(&c->generated,NULL)!=0){ pthread_mutex_destroy(&c->mu); util_aligned_free(c->entry); free(c->bucket); return -1; }
+    c->layout=layout; c->capacity=capacity; c->bucketMask=buckets-1u;
+    // Every entry starts on the LRU list as an empty slot (failed, so never found by a lookup)
+    for(int i=0;i<capacity;++i){
+        BoardCacheEntry* e=&c->entry[i];
+        e->failed=true; e->ready=true;
+        e->prev = i ? &c->entry[i-1] : NULL; e->next = i+1<capacity ? &c->entry[i+1] : NULL;
+    }
+    c->head=&c->entry[0]; c->tail=&c->entry[capacity-1];
+    return 0;
+}
+
+void board_cache_free(BoardCache* c){
+    for(int i=0;i<c->capacity;++i) board_free(&c->entry[i].board);
+    pthread_cond_destroy(&c->generated); pthread_mutex_destroy(&c->mu);
+    util_aligned_free(c->entry); free(c->bucket);
+    memset(c,0,sizeof *c);
+}
+
+static void lru_unlink(BoardCache* c, BoardCacheEntry* e){
+    if(e->prev) e->prev->next=e->next; else c->head=e->next;
+    if(e->next) e->next->prev=e->prev; else c->tail=e->prev;
+}
+
+static void lru_push_front(BoardCache* c, BoardCacheEntry* e){
+    e->prev=NULL; e->next=c->head;
+    if(c->head) c->head->prev=e; else c->tail=e;
+    c->head=e;
+}
+
+static void hash_remove(BoardCache* c, BoardCacheEntry* e){
+    for(BoardCacheEntry** p=&c->bucket[seed_hash(e->seed)&c->bucketMask];*p;p=&(*p)->hashNext)
+        if(*p==e){ *p=e->hashNext; break; }
+    e->hashNext=NULL;
+}
+
+static bool generate(const BoardCache* c, Board* b, unsigned seed){
+    if(c->layout) return board_init_from_layout(b,c->layout,seed)==0;
+    board_init(b,seed);
+    return b->maze.defaultLayout; // cleared when the parse ran out of memory
+}
+
+const Board* board_cache_acquire(BoardCache* c, unsigned seed){
+    pthread_mutex_lock(&c->mu);
+    BoardCacheEntry* e=c->bucket[seed_hash(seed)&c->bucketMask];
+    while(e && e->seed!=seed) e=e->hashNext;
+    if(e){
+        c->hits++;
+        e->refs++;
+        lru_unlink(c,e); lru_push_front(c,e);
+        while(!e->ready) pthread_cond_wait(&c->generated,&c->mu);
+        bool failed=e->failed;
+        if(failed) e->refs--;
+        pthread_mutex_unlock(&c->mu);
+        return failed ? NULL : &e->board;
+    }
+    c->misses++;
+    // Least recently used entry nobody holds; its storage (maze arena included) is reused
+    BoardCacheEntry* victim=c->tail;
+    while(victim && victim->refs) victim=victim->prev;
+    if(!victim){
+        c->overflows++;
+        pthread_mutex_unlock(&c->mu);
+        BoardCacheEntry* own=util_aligned_calloc(1,sizeof *own,_Alignof(BoardCacheEntry));
+        if(!own) return NULL;
+        own->overflow=true;
+        if(!generate(c,&own->board,seed)){ board_free(&own->board); util_aligned_free(own); return NULL; }
+        return &own->board;
+    }
+    if(!victim->failed) hash_remove(c,victim);
+    victim->seed=seed; victim->refs=1; victim->ready=false; victim->failed=false;
+    BoardCacheEntry** bucket=&c->bucket[seed_hash(seed)&c->bucketMask];
+    victim->hashNext=*bucket; *bucket=victim;
+    lru_unlink(c,victim); lru_push_front(c,victim);
+    pthread_mutex_unlock(&c->mu);
+
+    bool ok=generate(c,&victim->board,seed);
+
+    pthread_mutex_lock(&c->mu);
+    victim->ready=true;
+    if(!ok){ // out of the table and first in line for reuse
+        victim->failed=true; victim->refs--; hash_remove(c,victim);
+        lru_unlink(c,victim); victim->prev=c->tail; victim->next=NULL;
+        if(c->tail) c->tail->next=victim; else c->head=victim;
+        c->tail=victim;
+    }
+    pthread_cond_broadcast(&c->generated);
+    pthread_mutex_unlock(&c->mu);
+    return ok ? &victim->board : NULL;
+}
+
+void board_cache_release(BoardCache* c, const Board* b){
+    if(!b) return;
+    BoardCacheEntry* e=(BoardCacheEntry*)(uintptr_t)b; // board is the first member
+    if(e->overflow){ board_free(&e->board); util_aligned_free(e); return; }
+    pthread_mutex_lock(&c->mu);
+    e->refs--;
+    pthread_mutex_unlock(&c->mu);
+}
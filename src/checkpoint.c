@@ -0,0 +1,203 @@
+#define _POSIX_C_SOURCE 200809L
+#include "checkpoint.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+static uint64_t align64(uint64_t v){ return (v+63u)&~(uint64_t)63u; }
+
+static uint32_t record_size(int players){ return (uint32_t)(sizeof(CheckpointRecord)+sizeof(CheckpointPlayer)*(size_t)players); }
+
+static void header_fill(CheckpointHeader* h, const Game* g){
+    const Board* b=g->board;
+    int players=g->playerCount;
+    memset(h,0,sizeof *h);
+    memcpy(h->magic,CHECKPOINT_MAGIC,8);
+    h->version=CHECKPOINT_VERSION;
+    h->headerSize=(uint32_t)sizeof(CheckpointHeader);
+    h->boardSize=(uint32_t)sizeof(Board);
+    h->recordSize=record_size(players);
+    h->boardOffset=align64(sizeof(CheckpointHeader));
+    h->arenaOffset=align64(h->boardOffset+sizeof(Board));
+    h->arenaSize=b->maze.arenaSize;
+    h->recordsOffset=align64(h->arenaOffset+h->arenaSize);
+    h->boardSeed=b->seed;
+    h->players=(uint32_t)players;
+    h->diceSeed=g->seed;
+}
+
+static bool header_compatible(const CheckpointHeader* h){
+    return memcmp(h->magic,CHECKPOINT_MAGIC,8)==0 && h->version==CHECKPOINT_VERSION &&
+        h->headerSize==sizeof(CheckpointHeader) && h->boardSize==sizeof(Board) && h->players>=1 && h->players<=GAME_MAX_PLAYERS &&
+        h->recordSize==record_size((int)h->players);
+}
+
+// Zero-fill up to the next aligned section
+static bool pad_to(FILE* f, uint64_t offset){
+    static const char zeros[64];
+    long at=ftell(f);
+    return at>=0 && (uint64_t)at<=offset && fwrite(zeros,1,(size_t)(offset-(uint64_t)at),f)==(size_t)(offset-(uint64_t)at);
+}
+
+int checkpoint_writer_open(CheckpointWriter* w, const char* path, const Game* g, bool append){
+    const Board* b=g->board;
+    w->f=NULL; w->count=0;
+    CheckpointHeader h; header_fill(&h,g);
+    w->recordSize=h.recordSize;
+    if(!(w->record=malloc(h.recordSize))) return -1;
+    if(append && (w->f=fopen(path,"r+b"))!=NULL){
+        // Existing file must have the same layout and the very same board
+        CheckpointHeader old;
+        Board image;
+        void* arena=NULL;
+        bool ok = fread(&old,sizeof old,1,w->f)==1 && header_compatible(&old) && old.players==h.players && old.diceSeed==h.diceSeed && old.arenaSize==h.arenaSize &&
+            fseek(w->f,(long)old.boardOffset,SEEK_SET)==0 && fread(&image,sizeof image,1,w->f)==1 &&
+            (arena=malloc(old.arenaSize ? old.arenaSize : 1))!=NULL &&
+            fseek(w->f,(long)old.arenaOffset,SEEK_SET)==0 && fread(arena,1,old.arenaSize,w->f)==old.arenaSize;
+        if(ok){ ok = maze_attach(&image.maze,arena,old.arenaSize)==0 && image.seed==b->seed && maze_equal(&image.maze,&b->maze) && fseek(w->f,0,SEEK_END)==0; }
+        free(arena);
+        if(!ok){ fclose(w->f); w->f=NULL; return -1; }
+        long end=ftell(w->f);
+        w->count = end>(long)old.recordsOffset ? ((uint64_t)end-old.recordsOffset)/old.recordSize : 0;
+        w->recordsOffset=old.recordsOffset;
+        // Drop a torn trailing record by positioning right after the last whole one
+        return fseek(w->f,(long)(old.recordsOffset+w->count*old.recordSize),SEEK_SET)==0 ? 0 : -1;
+    }
+    w->f=fopen(path,"w+b");
+    if(!w->f) return -1;
+    bool ok = fwrite(&h,sizeof h,1,w->f)==1 && pad_to(w->f,h.boardOffset) &&
+        fwrite(b,sizeof *b,1,w->f)==1 && pad_to(w->f,h.arenaOffset) &&
+        fwrite(b->maze.arena,1,h.arenaSize,w->f)==h.arenaSize && pad_to(w->f,h.recordsOffset);
+    if(!ok){ fclose(w->f); w->f=NULL; return -1; }
+    w->recordsOffset=h.recordsOffset;
+    return 0;
+}
+
+int checkpoint_writer_rewind(CheckpointWriter* w, int round){
+    // Rounds are non-decreasing: walk back from the end until a record precedes round
+    CheckpointRecord r; // fixed part only
+    while(w->count>0){
+        if(fseek(w->f,(long)(w->recordsOffset+(w->count-1)*w->recordSize),SEEK_SET)!=0 || fread(&r,sizeof r,1,w->f)!=1) return -1;
+        if(r.roundNumber<round) break;
+        w->count--;
+    }
+    long end=(long)(w->recordsOffset+w->count*w->recordSize);
+    if(fflush(w->f)!=0 || fseek(w->f,end,SEEK_SET)!=0) return -1;
+#ifdef _WIN32
+    return _chsize_s(_fileno(w->f),end)==0 ? 0 : -1;
+#else
+    return ftruncate(fileno(w->f),(off_t)end)==0 ? 0 : -1;
+#endif
+}
+
+static void record_from_game(CheckpointRecord* r, const Game* g){
+    memset(r,0,sizeof *r);
+    r->roundNumber=g->roundNumber;
+    for(int i=0;i<4;++i) r->rng[i]=g->rng.s[i];
+    r->stairDirectionChangeCountdown=g->stairDirectionChangeCountdown; r->stairDirectionMode=g->stairDirectionMode;
+    memcpy(r->stairUp,g->stairUp,sizeof r->stairUp); memcpy(r->stairDown,g->stairDown,sizeof r->stairDown);
+    r->flagFloor=g->flagFloor; r->flagX=g->flagX; r->flagY=g->flagY;
+    r->stairCycleRounds=g->config.stairCycleRounds; r->forceOneWay=g->config.forceOneWay; r->alternateDirections=g->config.alternateDirections;
+    r->totalStairCycles=g->totalStairCycles;
+    for(int i=0;i<g->playerCount;++i){
+        const Player* p=&g->players[i]; CheckpointPlayer* cp=&r->players[i];
+        *cp=(CheckpointPlayer){ p->floor,p->x,p->y,p->inMaze,(int32_t)p->dir, p->movementPoints,p->skipTurns,p->randomDisoriented,p->triggered,p->disorientedTurnsRemaining,
+            p->bawanaEffectType,p->bawanaEffectTurns, p->directionRollCounter,p->movesSinceEntry,
+            p->stepsMoved,p->capturesDone,p->timesCaptured,p->stairsUsed,p->polesUsed,p->bawanaVisits };
+    }
+}
+
+int checkpoint_append(CheckpointWriter* w, const Game* g){
+    if(record_size(g->playerCount)!=w->recordSize) return -1;
+    record_from_game(w->record,g);
+    if(fwrite(w->record,w->recordSize,1,w->f)!=1) return -1;
+    w->count++;
+    return 0;
+}
+
+void checkpoint_writer_close(CheckpointWriter* w){
+    if(w->f){ fclose(w->f); w->f=NULL; }
+    free(w->record); w->record=NULL;
+}
+
+static int checkpoint_attach(Checkpoint* c){
+    const CheckpointHeader* h=c->base;
+    if(c->size<sizeof *h || !header_compatible(h) || c->size<h->recordsOffset) return -1;
+    if(h->boardOffset>c->size || c->size-h->boardOffset<sizeof(Board) || h->arenaOffset%64 || h->arenaOffset>c->size || h->arenaSize>c->size-h->arenaOffset) return -1;
+    c->header=h;
+    // The struct image carries stale pointers: copy it out and point the maze into the mapped arena
+    if(!(c->board=util_aligned_calloc(1,sizeof *c->board,_Alignof(Board)))) return -1;
+    memcpy(c->board,(const char*)c->base+h->boardOffset,sizeof *c->board);
+    if(maze_attach(&c->board->maze,(char*)c->base+h->arenaOffset,h->arenaSize)!=0){ util_aligned_free(c->board); c->board=NULL; return -1; }
+    c->records=(const char*)c->base+h->recordsOffset;
+    c->count=(c->size-h->recordsOffset)/h->recordSize;
+    return 0;
+}
+
+int checkpoint_map(Checkpoint* c, const char* path){
+    memset(c,0,sizeof *c);
+    if(util_map_file(path,&c->base,&c->size)!=0) return -1;
+    if(checkpoint_attach(c)!=0){ checkpoint_unmap(c); return -1; }
+    return 0;
+}
+
+void checkpoint_unmap(Checkpoint* c){
+    util_aligned_free(c->board);
+    util_unmap_file(c->base,c->size);
+    memset(c,0,sizeof *c);
+}
+
+int64_t checkpoint_find_round(const Checkpoint* c, int round){
+    if(!c->count) return -1;
+    // One snapshot per round is the normal case: direct index
+    int64_t guess = (int64_t)round - checkpoint_record(c,0)->roundNumber;
+    if(guess>=0 && (uint64_t)guess<c->count && checkpoint_record(c,(uint64_t)guess)->roundNumber==round) return guess;
+    // Sparse files: rounds are non-decreasing, binary search for the first match
+    uint64_t lo=0, hi=c->count;
+    while(lo<hi){ uint64_t mid=lo+(hi-lo)/2; if(checkpoint_record(c,mid)->roundNumber<round) lo=mid+1; else hi=mid; }
+    return (lo<c->count && checkpoint_record(c,lo)->roundNumber==round) ? (int64_t)lo : -1;
+}
+
+// A record only ever holds states the engine reaches: players in the maze stand on it, the others on
+// their start spot (on any floor, since a capture keeps the floor), and every direction is a Direction
+static bool record_sane(const Checkpoint* c, const CheckpointRecord* r){
+    const Maze* m=&c->board->maze;
+    if(r->stairCycleRounds<1 || r->roundNumber<0 || !maze_in_bounds(m,r->flagFloor,r->flagX,r->flagY)) return false;
+    for(uint32_t i=0;i<c->header->players;++i){
+        const CheckpointPlayer* p=&r->players[i];
+        const MazeStart* s=&m->starts[i % (uint32_t)m->startCount];
+        if(p->dir<0 || p->dir>3 || p->bawanaEffectType<-1 || p->bawanaEffectType>4) return false;
+        if(p->inMaze ? !maze_in_bounds(m,p->floor,p->x,p->y) : (p->floor<0 || p->floor>=m->floors || p->x!=s->x || p->y!=s->y)) return false;
+    }
+    return true;
+}
+
+int checkpoint_restore(const Checkpoint* c, uint64_t index, Game* g){
+    if(index>=c->count) return -1;
+    const CheckpointRecord* r=checkpoint_record(c,index);
+    if(!record_sane(c,r)) return -1;
+    // Start from a clean game on the mapped board, then overwrite every mutable field
+    game_init_from_board(g,c->board,c->header->diceSeed);
+    if(game_set_players(g,(int)c->header->players)!=0) return -1;
+    game_set_config(g,(GameConfig){ .stairCycleRounds=r->stairCycleRounds, .forceOneWay=r->forceOneWay!=0, .alternateDirections=r->alternateDirections!=0 });
+    g->roundNumber=r->roundNumber;
+    for(int i=0;i<4;++i) g->rng.s[i]=r->rng[i];
+    g->stairDirectionChangeCountdown=r->stairDirectionChangeCountdown; g->stairDirectionMode=r->stairDirectionMode;
+    memcpy(g->stairUp,r->stairUp,sizeof g->stairUp); memcpy(g->stairDown,r->stairDown,sizeof g->stairDown);
+    g->flagFloor=r->flagFloor; g->flagX=r->flagX; g->flagY=r->flagY;
+    g->totalStairCycles=r->totalStairCycles;
+    for(int i=0;i<g->playerCount;++i){
+        const CheckpointPlayer* cp=&r->players[i];
+        g->players[i]=(Player){ cp->floor,cp->x,cp->y,cp->inMaze!=0,(Direction)cp->dir, cp->movementPoints,cp->skipTurns,cp->randomDisoriented!=0,cp->triggered!=0,
+            cp->disorientedTurnsRemaining, cp->bawanaEffectType,cp->bawanaEffectTurns, cp->directionRollCounter,cp->movesSinceEntry,-1,
+            cp->stepsMoved,cp->capturesDone,cp->timesCaptured,cp->stairsUsed,cp->polesUsed,cp->bawanaVisits };
+    }
+    game_reindex(g);
+    return 0;
+}
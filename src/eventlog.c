@@ -0,0 +1,118 @@
+#include "eventlog.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+int eventlog_file_open(EventLogFile* lf, const char* path){
+    lf->failed=false;
+    lf->f=fopen(path,"wb");
+    if(!lf->f) return -1;
+    EventLogHeader h; memset(&h,0,sizeof h);
+    memcpy(h.magic,EVLOG_MAGIC,8);
+    h.version=EVLOG_VERSION; h.recordSize=(uint32_t)sizeof(EventLogRecord);
+    if(fwrite(&h,sizeof h,1,lf->f)!=1){ fclose(lf->f); lf->f=NULL; return -1; }
+    pthread_mutex_init(&lf->mu,NULL);
+    return 0;
+}
+
+int eventlog_file_close(EventLogFile* lf){
+    if(!lf->f) return -1;
+    if(fclose(lf->f)!=0) lf->failed=true;
+    lf->f=NULL;
+    pthread_mutex_destroy(&lf->mu);
+    return lf->failed ? -1 : 0;
+}
+
+int eventlog_init(EventLog* log, EventLogFile* lf, uint32_t stream){
+    // One allocation: block header immediately followed by its records, written with a single fwrite
+    log->block=malloc(sizeof(EventLogBlock)+EVLOG_BLOCK_RECORDS*sizeof(EventLogRecord));
+    if(!log->block) return -1;
+    log->file=lf;
+    log->block->stream=stream; log->block->count=0;
+    log->records=(EventLogRecord*)(log->block+1);
+    log->next=NULL; log->nextUser=NULL;
+    return 0;
+}
+
+int eventlog_flush(EventLog* log){
+    EventLogBlock* b=log->block;
+    if(!b->count) return 0;
+    size_t bytes=sizeof *b+b->count*sizeof(EventLogRecord);
+    pthread_mutex_lock(&log->file->mu);
+    bool ok = fwrite(b,1,bytes,log->file->f)==bytes;
+    if(!ok) log->file->failed=true;
+    pthread_mutex_unlock(&log->file->mu);
+    b->count=0;
+    return ok ? 0 : -1;
+}
+
+void eventlog_free(EventLog* log){
+    if(!log->block) return;
+    eventlog_flush(log);
+    free(log->block); log->block=NULL;
+}
+
+static uint16_t pack_actor(int id){ return (id<0 || id>=UINT16_MAX) ? UINT16_MAX : (uint16_t)id; }
+static int unpack_actor(uint16_t v){ return v==UINT16_MAX ? -1 : (int)v; }
+
+static uint16_t pack_coord(int v){ return (v<0 || v>UINT16_MAX) ? 0 : (uint16_t)v; }
+
+static void put(EventLog* log, int type, int player, int other, int floor, int x, int y, int32_t value){
+    if(log->block->count==EVLOG_BLOCK_RECORDS) eventlog_flush(log);
+    log->records[log->block->count++] = (EventLogRecord){ (uint8_t)type, 0, pack_actor(player), pack_actor(other),
+        pack_coord(floor), pack_coord(x), pack_coord(y), value };
+}
+
+void eventlog_begin_game(EventLog* log, unsigned seed, int players){ put(log,EVLOG_GAME_BEGIN,-1,players,0,0,0,(int32_t)seed); }
+void eventlog_end_game(EventLog* log, const Game* g, int winner){ put(log,EVLOG_GAME_END,winner,winner<0?-winner:-1,0,0,0,g->roundNumber); }
+
+void eventlog_sink(const GameEvent* ev, void* user){
+    EventLog* log=user;
+    put(log,(int)ev->type,ev->player,ev->other,ev->floor,ev->x,ev->y,ev->value);
+    if(log->next) log->next(ev,log->nextUser);
+}
+
+void eventlog_attach(EventLog* log, Game* g){
+    log->next=g->sink; log->nextUser=g->sinkUser;
+    game_set_sink(g,eventlog_sink,log);
+}
+
+int eventlog_map(EventLogMap* m, const char* path){
+    if(util_map_file(path,&m->base,&m->size)!=0) return -1;
+    const EventLogHeader* h=m->base;
+    if(m->size<sizeof *h || memcmp(h->magic,EVLOG_MAGIC,8)!=0 || h->version!=EVLOG_VERSION || h->recordSize!=sizeof(EventLogRecord)){
+        eventlog_unmap(m); return -1;
+    }
+    return 0;
+}
+
+void eventlog_unmap(EventLogMap* m){ util_unmap_file(m->base,m->size); m->base=NULL; m->size=0; }
+
+void eventlog_cursor_init(EventLogCursor* c, const EventLogMap* m, uint32_t stream){
+    c->map=m; c->stream=stream;
+    c->blockOffset=0; c->blockStream=0; c->index=0; c->count=0; c->truncated=false; // no current block yet
+}
+
+const EventLogRecord* eventlog_next(EventLogCursor* c){
+    const char* base=c->map->base;
+    while(c->index>=c->count){
+        if(c->truncated) return NULL;
+        // Advance to the next block of the wanted stream; a truncated trailing block is cut to whole records
+        size_t off = c->blockOffset ? c->blockOffset+sizeof(EventLogBlock)+(size_t)c->count*sizeof(EventLogRecord) : sizeof(EventLogHeader);
+        if(off+sizeof(EventLogBlock)>c->map->size) return NULL;
+        EventLogBlock b; memcpy(&b,base+off,sizeof b);
+        size_t avail=(c->map->size-off-sizeof b)/sizeof(EventLogRecord);
+        c->blockOffset=off; c->blockStream=b.stream; c->index=0;
+        c->truncated = b.count>avail;
+        c->count = c->truncated ? (uint32_t)avail : b.count;
+        if(c->stream!=EVLOG_ALL_STREAMS && b.stream!=c->stream) c->index=c->count; // skip other writers' blocks
+    }
+    return (const EventLogRecord*)(base+c->blockOffset+sizeof(EventLogBlock))+c->index++;
+}
+
+void eventlog_decode(const EventLogRecord* r, GameEvent* ev){
+    ev->type=(GameEventType)r->type;
+    ev->player=unpack_actor(r->player); ev->other=unpack_actor(r->other);
+    ev->value=r->value;
+    ev->floor=r->floor; ev->x=r->x; ev->y=r->y;
+}
@@ -1,118 +1,287 @@
 #include "game.h"
+#include "profile.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stddef.h>
 
-static unsigned lcg(unsigned *state){ *state = (*state * 1664525u + 1013904223u); return *state; }
+// Event emission; build with -DGAME_HEADLESS to compile all engine output away
+#ifdef GAME_HEADLESS
+#define EMIT(g,...) ((void)(g))
+#define GAME_EMITS(g) ((void)(g),false)
+#else
+#define EMIT(g,...) do{ if((g)->sink){ GameEvent ev_=(GameEvent){__VA_ARGS__}; (g)->sink(&ev_,(g)->sinkUser); } }while(0)
+#define GAME_EMITS(g) ((g)->sink!=NULL)
+#endif
+
+// Engine variants: the turn and round-end code is written once against these bits and instantiated
+// for every combination (engines[] below), so a variant carries no branch on a rule it cannot meet.
+// The game's variant is picked whenever its sink, chooser or config is set.
+enum { VAR_EMITS=1, VAR_CHOOSER=2, VAR_ONE_WAY=4, VAR_ALTERNATE=8, VAR_COUNT=16 };
+#define ENGINE_INLINE static inline __attribute__((always_inline))
+#define EMIT_V(v,g,...) do{ if((v)&VAR_EMITS) EMIT(g,__VA_ARGS__); }while(0)
+
+static void select_engine(Game* g);
 
 static const char* dir_name(Direction d){ return (const char*[4]){"N","E","S","W"}[d]; }
 
+static const MazeStart* player_start(const Game* g, int pid){
+    const Maze* m=&g->board->maze;
+    return &m->starts[pid % m->startCount];
+}
+
+static int32_t player_cell(const Game* g, const Player* p){ return maze_cell_index(&g->board->maze,p->floor,p->x,p->y); }
+
+// ---- Occupancy index (see GameOccSlot) ----
+
+static uint32_t occ_hash(int32_t cell){ uint32_t h=(uint32_t)cell*0x9E3779B1u; return h^(h>>16); }
+
+static uint32_t occ_slots(int players){ uint32_t slots=4; while(slots<2u*(uint32_t)players) slots*=2; return slots; }
+
+static void occ_clear(Game* g){
+    uint32_t slots=occ_slots(g->playerCount);
+    g->occMask=slots-1;
+    for(uint32_t s=0;s<slots;++s) g->occ[s]=(GameOccSlot){GAME_OCC_EMPTY,-1};
+}
+
+// Grows g's heap block to hold count players and their occupancy slots (the contents are not kept)
+static int heap_reserve(Game* g, int count){
+    if(count<=g->heapPlayers) return 0;
+    void* block=malloc(sizeof(Player)*(size_t)count+sizeof(GameOccSlot)*occ_slots(count));
+    if(!block) return -1;
+    free(g->heap);
+    g->heap=block; g->heapPlayers=count;
+    return 0;
+}
+
+// Points players/occ at storage for playerCount: the inline arrays, or the heap block holding both
+static int players_storage(Game* g){
+    g->players=g->inlinePlayers; g->occ=g->inlineOcc;
+    if(g->playerCount<=GAME_INLINE_PLAYERS) return 0;
+    if(heap_reserve(g,g->playerCount)!=0) return -1;
+    g->players=g->heap; g->occ=(GameOccSlot*)(g->players+g->heapPlayers);
+    return 0;
+}
+
+// Slot holding cell, or the empty slot it would take
+static uint32_t occ_find(const Game* g, int32_t cell){
+    uint32_t s=occ_hash(cell)&g->occMask;
+    while(g->occ[s].cell!=GAME_OCC_EMPTY && g->occ[s].cell!=cell) s=(s+1)&g->occMask;
+    return s;
+}
+
+static void occ_add(Game* g, int pid, int32_t cell){
+    GameOccSlot* slot=&g->occ[occ_find(g,cell)];
+    if(slot->cell==GAME_OCC_EMPTY){ slot->cell=cell; slot->head=-1; }
+    int* link=&slot->head;
+    while(*link>=0 && *link<pid) link=&g->players[*link].occNext;
+    g->players[pid].occNext=*link; *link=pid;
+}
+
+// false when pid is not listed on cell: the index is stale (a position was written directly)
+static bool occ_remove(Game* g, int pid, int32_t cell){
+    uint32_t s=occ_find(g,cell), mask=g->occMask;
+    if(g->occ[s].cell!=cell) return false;
+    int* link=&g->occ[s].head;
+    while(*link>=0 && *link!=pid) link=&g->players[*link].occNext;
+    if(*link<0) return false;
+    *link=g->players[pid].occNext;
+    if(g->occ[s].head>=0) return true;
+    // Cell now empty: backward-shift deletion, so no probe chain runs through a hole
+    g->occ[s].cell=GAME_OCC_EMPTY;
+    for(uint32_t j=(s+1)&mask; g->occ[j].cell!=GAME_OCC_EMPTY; j=(j+1)&mask){
+        uint32_t home=occ_hash(g->occ[j].cell)&mask;
+        if(((j-home)&mask) >= ((j-s)&mask)){ g->occ[s]=g->occ[j]; g->occ[j].cell=GAME_OCC_EMPTY; s=j; }
+    }
+    return true;
+}
+
+static void occ_move(Game* g, int pid, int32_t from, int32_t to){
+    if(from==to) return;
+    if(occ_remove(g,pid,from)) occ_add(g,pid,to);
+    else game_reindex(g); // rebuilt from the positions, which already include this move
+}
+
+void game_reindex(Game* g){
+    occ_clear(g);
+    for(int i=0;i<g->playerCount;++i) if(g->players[i].inMaze) occ_add(g,i,player_cell(g,&g->players[i]));
+}
+
 static void players_init(Game* g){
-    // Starting area positions (outside maze), we store negative y to differentiate
-    // Use given starting area coords (A:6,12 first cell 5,12 dir N etc)
-    g->players[PLAYER_A]=(Player){0,6,12,false,DIR_N,100,0,false,false,0,-1,0,0,0,0,0,0,0};
-    g->players[PLAYER_B]=(Player){0,9,8,false,DIR_W,100,0,false,false,0,-1,0,0,0,0,0,0,0};
-    g->players[PLAYER_C]=(Player){0,9,16,false,DIR_E,100,0,false,false,0,-1,0,0,0,0,0,0,0};
+    // Starting area positions (outside maze) from the board's start list (default A:6,12 first cell 5,12 dir N etc)
+    for(int i=0;i<g->playerCount;++i){
+        const MazeStart* s=player_start(g,i);
+        g->players[i]=(Player){s->floor,s->x,s->y,false,(Direction)s->dir,100,0,false,false,0,-1,0,0,0,-1,0,0,0,0,0,0};
+    }
     // stats already zeroed via initializer
-    for(int i=0;i<PLAYER_COUNT;++i) g->directionRollCounter[i]=0;
-    for(int i=0;i<PLAYER_COUNT;++i) g->movesSinceEntry[i]=0;
+    occ_clear(g);
 }
 
-void game_init(Game* g, unsigned seed){
-    g->rng = seed?seed:(unsigned)time(NULL);
-    maze_init(&g->maze,g->rng^0xABCDEFu);
+// Deterministic Bawana cell type distribution: 3/16 of the interior for each special type (0..3), rest random MP (4)
+static void bawana_types_init(Board* b){
+    Maze* m=&b->maze;
+    Rng rng; rng_seed(&rng,b->seed,RNG_STREAM_BAWANA);
+    int8_t* types=m->bawanaTypes; int area=m->bawanaArea, idx=0;
+    for(int t=0;t<4;++t) for(int k=0;k<area*3/16;++k) types[idx++]=(int8_t)t;
+    while(idx<area) types[idx++]=4;
+    for(int i=area-1;i>0;--i){ unsigned r = rng_bounded(&rng,(uint32_t)(i+1)); int8_t swap=types[i]; types[i]=types[r]; types[r]=swap; }
+}
+
+void board_init(Board* b, unsigned seed){
+    b->seed = seed;
+    maze_init(&b->maze,seed);
+    bawana_types_init(b);
+}
+
+int board_init_from_layout(Board* b, const Maze* layout, unsigned seed){
+    if(maze_copy(&b->maze,layout)!=0) return -1;
+    b->seed = seed;
+    maze_randomize(&b->maze,seed);
+    bawana_types_init(b);
+    return 0;
+}
+
+void board_free(Board* b){ maze_free(&b->maze); }
+
+void game_init_from_board(Game* g, const Board* b, unsigned seed){
+    g->board = b;
+    g->seed = seed?seed:(unsigned)time(NULL);
+    rng_seed(&g->rng,g->seed,RNG_STREAM_DICE);
+    g->playerCount=GAME_DEFAULT_PLAYERS;
+    players_storage(g); // inline: cannot fail
     players_init(g);
+    memset(g->stairUp,0,sizeof g->stairUp); memset(g->stairDown,0,sizeof g->stairDown);
+    for(int i=0;i<b->maze.stairCount;++i){
+        if(b->maze.stairs[i].enabledUp) g->stairUp[i>>6] |= 1ull<<(i&63);
+        if(b->maze.stairs[i].enabledDown) g->stairDown[i>>6] |= 1ull<<(i&63);
+    }
+    g->flagFloor=b->maze.flagFloor; g->flagX=b->maze.flagX; g->flagY=b->maze.flagY;
     g->roundNumber=0;
     g->stairDirectionChangeCountdown=5; // every 5 rounds
     g->stairDirectionMode=0;
     g->config = (GameConfig){ .stairCycleRounds=5, .forceOneWay=true, .alternateDirections=true };
     g->stairDirectionChangeCountdown = g->config.stairCycleRounds;
     g->totalStairCycles=0;
-    // Initialize deterministic Bawana cell type distribution
-    int temp[16]; int idx=0;
-    for(int t=0;t<4;++t) for(int k=0;k<3;++k) temp[idx++]=t; // 12 cells of special types (0..3)
-    for(int k=0;k<4;++k) temp[idx++]=4; // 4 random MP cells
-    for(int i=15;i>0;--i){ unsigned r = lcg(&g->rng)%(unsigned)(i+1); int swap=temp[i]; temp[i]=temp[r]; temp[r]=swap; }
-    idx=0;
-    for(int x=BAWANA_X_MIN;x<=BAWANA_X_MAX;++x){
-        for(int y=BAWANA_Y_MIN;y<=BAWANA_Y_MAX;++y){
-            g->bawanaTypes[x-BAWANA_X_MIN][y-BAWANA_Y_MIN]=temp[idx++];
-        }
-    }
+    g->sink=game_print_event; g->sinkUser=NULL;
+    g->chooseDirection=NULL; g->chooserUser=NULL;
+    select_engine(g);
+}
+
+void game_set_config(Game* g, GameConfig c){
+    if(c.stairCycleRounds<1) c.stairCycleRounds=1;
+    g->config=c;
+    g->stairDirectionChangeCountdown=c.stairCycleRounds;
+    select_engine(g);
+}
+
+void game_init(Game* g, Board* b, unsigned seed){
+    if(!seed) seed=(unsigned)time(NULL);
+    board_init(b,seed);
+    game_init_from_board(g,b,seed);
+}
+
+int game_set_players(Game* g, int count){
+    if(count<1 || count>GAME_MAX_PLAYERS) return -1;
+    g->playerCount=count;
+    int rc=players_storage(g);
+    if(rc!=0){ g->playerCount=GAME_DEFAULT_PLAYERS; players_storage(g); } // still a valid default game
+    players_init(g);
+    return rc;
+}
+
+int game_reserve(Game* g, int count){
+    return count>GAME_INLINE_PLAYERS ? heap_reserve(g,count) : 0;
+}
+
+// Board is shared, not copied; dst keeps its own storage (grown only when too small), filled with the
+// slots and players in use
+int game_clone(Game* dst, const Game* src){
+    memcpy(dst,src,offsetof(Game,players));
+    if(players_storage(dst)!=0){ dst->playerCount=0; players_storage(dst); occ_clear(dst); return -1; }
+    memcpy(dst->occ,src->occ,sizeof(GameOccSlot)*(src->occMask+1u));
+    memcpy(dst->players,src->players,sizeof(Player)*(size_t)src->playerCount);
+    return 0;
+}
+
+void game_free(Game* g){
+    if(!g->heap) return;
+    bool large=g->players!=g->inlinePlayers;
+    free(g->heap);
+    g->heap=NULL; g->heapPlayers=0;
+    if(large){ g->playerCount=0; players_storage(g); occ_clear(g); } // an empty field until g is initialized again
 }
 
 // Stair direction toggling logic will be integrated later (Rule 6 placeholder removed to avoid warnings)
 
-static int roll_movement_die(Game* g){ return (int)(lcg(&g->rng)%6)+1; }
-static int roll_direction_die(Game* g){ return (int)(lcg(&g->rng)%6)+1; }
+static int roll_movement_die(Game* g){ PROFILE_COUNT(PROF_DICE); return (int)rng_bounded(&g->rng,6)+1; }
+static int roll_direction_die(Game* g){ PROFILE_COUNT(PROF_DICE); return (int)rng_bounded(&g->rng,6)+1; }
 
 static Direction direction_from_face(int face, Direction current){
     switch(face){
         case 2: return DIR_N; case 3: return DIR_E; case 4: return DIR_S; case 5: return DIR_W; default: return current; }
 }
 
-static bool attempt_enter_maze(Game* g, Player* p, PlayerId pid, int moveDie){
-    (void)g; // currently unused
+ENGINE_INLINE bool attempt_enter_maze(Game* g, Player* p, PlayerId pid, int moveDie, unsigned v){
     if(p->inMaze) return false;
     if(moveDie==6){
-        if(pid==PLAYER_A){ p->x=5; p->y=12; }
-        else if(pid==PLAYER_B){ p->x=9; p->y=7; }
-        else { p->x=9; p->y=17; }
+        PROFILE_BEGIN(PROF_ENTRY);
+        const MazeStart* s=player_start(g,pid);
+        p->x=s->entryX; p->y=s->entryY;
         p->inMaze=true;
-        printf("Player %d enters maze at (%d,%d)\n", pid, p->x,p->y);
+        occ_add(g,pid,player_cell(g,p));
+        EMIT_V(v,g,.type=GAME_EVENT_ENTER,.player=pid,.floor=p->floor,.x=p->x,.y=p->y);
+        PROFILE_END(PROF_ENTRY);
         return true;
     }
     return false;
 }
 
-static void resolve_stair_or_pole(Game* g, Player* p, bool midMove){
-    // Check stairs
-    for(int i=0;i<g->maze.stairCount;++i){
-        Stair* s=&g->maze.stairs[i];
-        if(p->floor==s->startFloor && p->x==s->startX && p->y==s->startY){
-            if(s->enabledUp) { p->floor=s->endFloor; p->x=s->endX; p->y=s->endY; p->stairsUsed++; return; }
-        }
-        if(p->floor==s->endFloor && p->x==s->endX && p->y==s->endY){
-            if(s->enabledDown){ p->floor=s->startFloor; p->x=s->startX; p->y=s->startY; p->stairsUsed++; return; }
-        }
-    }
-    // Poles (always down if from higher floor)
-    for(int i=0;i<g->maze.poleCount;++i){
-        Pole* pl=&g->maze.poles[i];
-        if(p->x==pl->x && p->y==pl->y){
-            if(p->floor==pl->fromFloor){ p->floor=pl->toFloor; p->polesUsed++; return; }
-            if(p->floor==pl->fromFloor-1){ p->floor=pl->toFloor; p->polesUsed++; return; }
-        }
-    }
+ENGINE_INLINE void resolve_stair_or_pole(Game* g, Player* p, bool midMove, unsigned v){
     (void)midMove;
-}
-
-static bool movement_blocked_wall(const Game* g,int f,int x,int y,Direction d){
-    unsigned w = g->maze.walls[f][x][y];
-    switch(d){
-        case DIR_N: return (w & CELL_WALL_N)!=0; case DIR_S: return (w & CELL_WALL_S)!=0; case DIR_E: return (w & CELL_WALL_E)!=0; case DIR_W: return (w & CELL_WALL_W)!=0;
+    const Maze* m=&g->board->maze;
+    const TeleportCell* tc = maze_find_teleport(m,maze_cell_index(m,p->floor,p->x,p->y));
+    if(!tc) return; // plain cell
+    for(uint32_t k=0;k<tc->count;++k){
+        uint32_t code = m->teleportCodes[tc->first+k];
+        if(code < TELEPORT_POLE_BASE){
+            uint32_t i = code>>1;
+            const Stair* s=&m->stairs[i];
+            if(code&1u){
+                if(!((g->stairDown[i>>6]>>(i&63))&1u)) continue;
+                p->floor=s->startFloor; p->x=s->startX; p->y=s->startY;
+            } else {
+                if(!((g->stairUp[i>>6]>>(i&63))&1u)) continue;
+                p->floor=s->endFloor; p->x=s->endX; p->y=s->endY;
+            }
+            p->stairsUsed++;
+            PROFILE_COUNT(PROF_STAIR);
+            EMIT_V(v,g,.type=GAME_EVENT_STAIR,.player=(int)(p-g->players),.other=!(code&1u),.value=(int)i,.floor=p->floor,.x=p->x,.y=p->y);
+            return;
+        }
+        // Poles (always down if from higher floor)
+        p->floor=m->poles[code-TELEPORT_POLE_BASE].toFloor; p->polesUsed++;
+        PROFILE_COUNT(PROF_POLE);
+        EMIT_V(v,g,.type=GAME_EVENT_POLE,.player=(int)(p-g->players),.value=(int)(code-TELEPORT_POLE_BASE),.floor=p->floor,.x=p->x,.y=p->y);
+        return;
     }
-    return false;
 }
 
 static bool can_step(const Game* g,int f,int x,int y,Direction d){
-    if(movement_blocked_wall(g,f,x,y,d)) return false;
-    int nx=x, ny=y;
-    switch(d){ case DIR_N: nx--; break; case DIR_S: nx++; break; case DIR_E: ny++; break; case DIR_W: ny--; break; }
-    if(!maze_cell_exists(&g->maze,f,nx,ny)) return false;
-    if(movement_blocked_wall(g,f,nx,ny,(Direction)((d+2)%4))) return false; // opposite wall
-    return true;
+    const Maze* m=&g->board->maze;
+    return (m->cells[maze_cell_index(m,f,x,y)] & (CELL_OPEN_N<<d)) != 0; // walls/bounds/validity folded into the open bits
 }
 
-static void send_to_bawana(Player* p){
-    p->floor=0; p->x=BAWANA_ENTRANCE_X; p->y=BAWANA_ENTRANCE_Y; p->dir=DIR_N; p->randomDisoriented=false; p->triggered=false; p->disorientedTurnsRemaining=0; p->bawanaEffectType=-1; p->bawanaEffectTurns=0; }
+static void send_to_bawana(const Maze* m, Player* p){
+    p->floor=m->bawana.floor; p->x=m->bawana.entranceX; p->y=m->bawana.entranceY; p->dir=DIR_N; p->randomDisoriented=false; p->triggered=false; p->disorientedTurnsRemaining=0; p->bawanaEffectType=-1; p->bawanaEffectTurns=0; }
 
+// Effect of the Bawana cell the player stands on; every type but poisoning then moves them to the entrance facing north
 static void assign_bawana_effect(Game* g, Player* p){
-    int typeIndexX = p->x-BAWANA_X_MIN;
-    int typeIndexY = p->y-BAWANA_Y_MIN;
-    if(typeIndexX>=0 && typeIndexX<= (BAWANA_X_MAX-BAWANA_X_MIN) && typeIndexY>=0 && typeIndexY<=(BAWANA_Y_MAX-BAWANA_Y_MIN)){
-        p->bawanaEffectType = g->bawanaTypes[typeIndexX][typeIndexY];
+    PROFILE_BEGIN(PROF_BAWANA);
+    const Maze* m=&g->board->maze;
+    const BawanaRegion* bw=&m->bawana;
+    if(maze_is_bawana(m,p->floor,p->x,p->y)){
+        p->bawanaEffectType = m->bawanaTypes[(p->x-bw->xMin)*(bw->yMax-bw->yMin+1)+(p->y-bw->yMin)];
     } else {
         // fallback
         p->bawanaEffectType = 4;
@@ -120,61 +289,95 @@ static void assign_bawana_effect(Game* g, Player* p){
     int type = p->bawanaEffectType;
     switch(type){
         case 0: // Food Poisoning
-            p->skipTurns=3; p->bawanaEffectTurns=3; printf("Bawana effect: Food Poisoning (skip 3).\n"); break;
+            p->skipTurns=3; p->bawanaEffectTurns=3; break;
         case 1: // Disoriented
-            p->movementPoints +=50; p->randomDisoriented=true; p->disorientedTurnsRemaining=4; printf("Bawana effect: Disoriented (random 4 turns +50 MP).\n"); break;
+            p->movementPoints +=50; p->randomDisoriented=true; p->disorientedTurnsRemaining=4; break;
         case 2: // Triggered
-            p->movementPoints +=50; p->triggered=true; p->bawanaEffectTurns=0; printf("Bawana effect: Triggered (+50 MP double speed).\n"); break;
+            p->movementPoints +=50; p->triggered=true; p->bawanaEffectTurns=0; break;
         case 3: // Happy
-            p->movementPoints +=200; printf("Bawana effect: Happy (+200 MP).\n"); break;
+            p->movementPoints +=200; break;
         case 4: // Random MP 10-100
-            p->movementPoints += (int)(lcg(&g->rng)%91)+10; printf("Bawana effect: Bonus MP random.\n"); break;
+            p->movementPoints += (int)rng_bounded(&g->rng,91)+10; break;
+    }
+    if(type!=0){ p->floor=bw->floor; p->x=bw->entranceX; p->y=bw->entranceY; p->dir=DIR_N; }
+    EMIT(g,.type=GAME_EVENT_BAWANA,.player=(int)(p-g->players),.value=type,.floor=p->floor,.x=p->x,.y=p->y);
+    PROFILE_END(PROF_BAWANA);
+}
+
+// Steps onto the plain cells straight ahead (up to steps of them) while MP stays above 0; returns how
+// many. The step after them (wall, stair/pole, Bawana, MP running out) is left to the per-step path.
+static int straight_run(Player* p, const Maze* m, int steps){
+    int c=maze_cell_index(m,p->floor,p->x,p->y), delta=maze_dir_delta(m,p->dir);
+    int n = m->runs[c*4+p->dir]<steps ? m->runs[c*4+p->dir] : steps;
+    int mp=p->movementPoints, k=0;
+    for(; k<n; ++k){
+        int next=maze_effect_apply(mp,m->effects[c+=delta]);
+        if(next<=0) break;
+        mp=next;
     }
+    if(!k) return 0;
+    p->movementPoints=mp;
+    switch(p->dir){ case DIR_N: p->x-=k; break; case DIR_S: p->x+=k; break; case DIR_E: p->y+=k; break; case DIR_W: p->y-=k; break; }
+    p->stepsMoved+=(unsigned)k;
+    PROFILE_COUNT(PROF_RUN); PROFILE_ADD(PROF_STEP,k);
+    return k;
 }
 
-static void perform_move(Game* g, Player* p, int steps, bool directionJustChanged){
+ENGINE_INLINE void perform_move(Game* g, Player* p, int steps, bool directionJustChanged, unsigned v){
     (void)directionJustChanged;
+    bool runs = !(v&VAR_EMITS); // a run has no per-step events
     for(int i=0;i<steps;++i){
         if(p->movementPoints<=0){ break; }
+        if(runs){
+            int k=straight_run(p,&g->board->maze,steps-i);
+            if(k){ i+=k-1; continue; }
+        }
         if(!can_step(g,p->floor,p->x,p->y,p->dir)){
             // blocked
             p->movementPoints -=2; // penalty per rule 12 when not moving at all for this step
+            PROFILE_COUNT(PROF_BLOCKED);
+            EMIT_V(v,g,.type=GAME_EVENT_BLOCKED,.player=(int)(p-g->players),.value=p->movementPoints,.floor=p->floor,.x=p->x,.y=p->y);
             break; // cannot proceed further
         }
         // step
         switch(p->dir){ case DIR_N: p->x--; break; case DIR_S: p->x++; break; case DIR_E: p->y++; break; case DIR_W: p->y--; break; }
-    p->stepsMoved++;
-        resolve_stair_or_pole(g,p,true);
+        p->stepsMoved++;
+        PROFILE_COUNT(PROF_STEP);
+        resolve_stair_or_pole(g,p,true,v);
         // Prevent entering Bawana interior except via entrance cell (one-way). If moved into interior directly without passing entrance, revert.
-        if(is_bawana_cell(p->floor,p->x,p->y)){
+        if(maze_is_bawana(&g->board->maze,p->floor,p->x,p->y)){
             // Determine previous cell coords
             int bx=p->x, by=p->y; // current interior
             int prevx=bx, prevy=by;
             switch(p->dir){ case DIR_N: prevx++; break; case DIR_S: prevx--; break; case DIR_E: prevy--; break; case DIR_W: prevy++; break; }
-            if(!is_bawana_entrance(p->floor,prevx,prevy)){
+            if(!maze_is_bawana_entrance(&g->board->maze,p->floor,prevx,prevy)){
                 // revert move and stop
-                p->x=prevx; p->y=prevy; p->movementPoints -=2; break;
+                p->x=prevx; p->y=prevy; p->movementPoints -=2;
+                PROFILE_COUNT(PROF_BLOCKED);
+                EMIT_V(v,g,.type=GAME_EVENT_BLOCKED,.player=(int)(p-g->players),.value=p->movementPoints,.floor=p->floor,.x=p->x,.y=p->y);
+                break;
             }
         }
-        p->movementPoints = maze_apply_effect(&g->maze,p->floor,p->x,p->y,p->movementPoints,NULL);
+        p->movementPoints = maze_apply_effect(&g->board->maze,p->floor,p->x,p->y,p->movementPoints,NULL);
+        EMIT_V(v,g,.type=GAME_EVENT_STEP,.player=(int)(p-g->players),.value=p->movementPoints,.floor=p->floor,.x=p->x,.y=p->y);
         if(p->movementPoints<=0){
-            printf("Movement points depleted -> Bawana\n");
-            send_to_bawana(p);
+            EMIT_V(v,g,.type=GAME_EVENT_MP_DEPLETED,.player=(int)(p-g->players));
+            send_to_bawana(&g->board->maze,p);
             assign_bawana_effect(g,p);
             return;
         }
-        if(is_bawana_cell(p->floor,p->x,p->y)){
-            // Landing inside Bawana triggers effect
+        if(maze_is_bawana(&g->board->maze,p->floor,p->x,p->y)){
+            // Landing inside Bawana triggers effect (poison keeps the player inside, others reposition to the entrance)
             p->bawanaVisits++;
             assign_bawana_effect(g,p);
-            // After certain effects (poison) player stays; others reposition to entrance with north direction
-            if(p->bawanaEffectType!=0){ p->x=BAWANA_ENTRANCE_X; p->y=BAWANA_ENTRANCE_Y; p->dir=DIR_N; }
             return;
         }
     }
 }
 
-bool game_take_turn(Game* g, PlayerId pid){
+ENGINE_INLINE bool resume_turn(Game* g, PlayerId pid, int moveDie, unsigned v);
+
+ENGINE_INLINE bool take_turn(Game* g, PlayerId pid, unsigned v){
     Player* p=&g->players[pid];
     // Expire disorientation
     if(p->disorientedTurnsRemaining>0){
@@ -182,77 +385,103 @@ bool game_take_turn(Game* g, PlayerId pid){
         if(p->disorientedTurnsRemaining==0){ p->randomDisoriented=false; }
     }
     if(p->skipTurns>0){
+        PROFILE_BEGIN(PROF_SKIP);
         p->skipTurns--;
-        printf("Player %d skips (remaining %d)\n",pid,p->skipTurns);
+        EMIT_V(v,g,.type=GAME_EVENT_SKIP,.player=pid,.value=p->skipTurns);
         if(p->skipTurns==0 && p->bawanaEffectType==0){
             // After poisoning period ends, relocate randomly and apply new effect immediately
-            int rx = (int)(lcg(&g->rng)%(unsigned)(BAWANA_X_MAX-BAWANA_X_MIN+1)) + BAWANA_X_MIN;
-            int ry = (int)(lcg(&g->rng)%(unsigned)(BAWANA_Y_MAX-BAWANA_Y_MIN+1)) + BAWANA_Y_MIN;
-            p->x=rx; p->y=ry; p->floor=0; assign_bawana_effect(g,p); if(p->bawanaEffectType!=0){ p->x=BAWANA_ENTRANCE_X; p->y=BAWANA_ENTRANCE_Y; p->dir=DIR_N; }
+            const BawanaRegion* bw=&g->board->maze.bawana;
+            int rx = (int)rng_bounded(&g->rng,(uint32_t)(bw->xMax-bw->xMin+1)) + bw->xMin;
+            int ry = (int)rng_bounded(&g->rng,(uint32_t)(bw->yMax-bw->yMin+1)) + bw->yMin;
+            int32_t from=player_cell(g,p);
+            p->x=rx; p->y=ry; p->floor=bw->floor; assign_bawana_effect(g,p);
+            if(p->inMaze) occ_move(g,pid,from,player_cell(g,p)); // a captured player serves the rest outside
         }
+        PROFILE_END(PROF_SKIP);
         return false;
     }
     int moveDie = roll_movement_die(g);
     bool rollDirection = false;
     if(p->inMaze){
-        if(g->movesSinceEntry[pid]>0 && (g->movesSinceEntry[pid] % 4)==0){ rollDirection=true; }
+        if(p->movesSinceEntry>0 && (p->movesSinceEntry % 4)==0){ rollDirection=true; }
     }
     int dirFace = 0;
-    if(rollDirection){ dirFace = roll_direction_die(g); p->dir = direction_from_face(dirFace,p->dir); }
-    g->directionRollCounter[pid]++;
+    if(rollDirection){
+        dirFace = roll_direction_die(g); p->dir = direction_from_face(dirFace,p->dir);
+        if(v&VAR_CHOOSER){
+            // Controlled player: the chooser may override the die with its own pick
+            int choice = g->chooseDirection(g,pid,moveDie,g->chooserUser);
+            if(choice>=0){ p->dir=(Direction)choice; EMIT_V(v,g,.type=GAME_EVENT_AI_DIRECTION,.player=pid,.value=choice); }
+        }
+    }
+    return resume_turn(g,pid,moveDie,v);
+}
 
-    bool justEntered = attempt_enter_maze(g,p,pid,moveDie);
+ENGINE_INLINE bool resume_turn(Game* g, PlayerId pid, int moveDie, unsigned v){
+    Player* p=&g->players[pid];
+    p->directionRollCounter++;
+
+    bool justEntered = attempt_enter_maze(g,p,pid,moveDie,v);
     if(!p->inMaze) return false; // still waiting to enter
 
     // If just entered, treat this turn as only the entry (no further movement per assignment wording)
     if(justEntered){
-        g->movesSinceEntry[pid]=1; // first in-maze turn completed
+        p->movesSinceEntry=1; // first in-maze turn completed
         // Immediate flag capture if entry cell is flag
-        if(p->floor==g->maze.flagFloor && p->x==g->maze.flagX && p->y==g->maze.flagY){
-            printf("Player %d captured the flag on entry! Game Over.\n", pid);
+        if(p->floor==g->flagFloor && p->x==g->flagX && p->y==g->flagY){
+            EMIT_V(v,g,.type=GAME_EVENT_FLAG,.player=pid,.value=1,.floor=p->floor,.x=p->x,.y=p->y);
             return true;
         }
         return false;
     }
-    if(g->movesSinceEntry[pid]==0) g->movesSinceEntry[pid]=1; else g->movesSinceEntry[pid]++;
+    if(p->movesSinceEntry==0) p->movesSinceEntry=1; else p->movesSinceEntry++;
 
     // Pre-move flag check (in case effects / teleports placed player on flag previously)
-    if(p->floor==g->maze.flagFloor && p->x==g->maze.flagX && p->y==g->maze.flagY){
-        printf("Player %d captured the flag! Game Over.\n", pid);
+    if(p->floor==g->flagFloor && p->x==g->flagX && p->y==g->flagY){
+        EMIT_V(v,g,.type=GAME_EVENT_FLAG,.player=pid,.floor=p->floor,.x=p->x,.y=p->y);
         return true;
     }
 
     int steps = moveDie;
     if(p->triggered) steps*=2;
-    if(p->randomDisoriented){ p->dir = (Direction)(lcg(&g->rng)%4); }
-    perform_move(g,p,steps,rollDirection);
+    if(p->randomDisoriented){ p->dir = (Direction)rng_bounded(&g->rng,4); }
+    int32_t from=player_cell(g,p);
+    PROFILE_BEGIN(PROF_MOVE);
+    perform_move(g,p,steps,false,v);
+    PROFILE_END(PROF_MOVE);
+    int32_t here=player_cell(g,p);
+    occ_move(g,pid,from,here);
 
-    // Capture logic
-    for(int i=0;i<PLAYER_COUNT;++i){
-        if((PlayerId)i == pid) continue;
+    // Capture logic: every other in-maze player on this cell, in id order, from the occupancy index
+    PROFILE_BEGIN(PROF_CAPTURE);
+    for(int i=g->occ[occ_find(g,here)].head; i>=0; ){
         Player* op=&g->players[i];
-        if(op->inMaze && p->inMaze && op->floor==p->floor && op->x==p->x && op->y==p->y){
+        int next=op->occNext;
+        if(i!=(int)pid){
             // send back to starting area
-            printf("Player %d captured player %d!\n", pid, i);
+            EMIT_V(v,g,.type=GAME_EVENT_CAPTURE,.player=pid,.other=i,.floor=p->floor,.x=p->x,.y=p->y);
             g->players[pid].capturesDone++;
             g->players[i].timesCaptured++;
-            if(i==PLAYER_A){ op->x=6; op->y=12; op->inMaze=false; op->dir=DIR_N; }
-            else if(i==PLAYER_B){ op->x=9; op->y=8; op->inMaze=false; op->dir=DIR_W; }
-            else { op->x=9; op->y=16; op->inMaze=false; op->dir=DIR_E; }
+            occ_remove(g,i,here); // the mover stays, so the slot does not move
+            const MazeStart* s=player_start(g,i);
+            op->x=s->x; op->y=s->y; op->inMaze=false; op->dir=(Direction)s->dir;
+            PROFILE_COUNT(PROF_CAPTURED);
         }
+        i=next;
     }
+    PROFILE_END(PROF_CAPTURE);
 
     // Post-move flag capture
-    if(p->floor==g->maze.flagFloor && p->x==g->maze.flagX && p->y==g->maze.flagY){
-        printf("Player %d captured the flag! Game Over.\n", pid);
+    if(p->floor==g->flagFloor && p->x==g->flagX && p->y==g->flagY){
+        EMIT_V(v,g,.type=GAME_EVENT_FLAG,.player=pid,.floor=p->floor,.x=p->x,.y=p->y);
         return true;
     }
     return false;
 }
 
 void game_print_status(const Game* g){
-    printf("Round %d Flag at F%d (%d,%d)\n", g->roundNumber,g->maze.flagFloor,g->maze.flagX,g->maze.flagY);
-    for(int i=0;i<PLAYER_COUNT;++i){
+    printf("Round %d Flag at F%d (%d,%d)\n", g->roundNumber,g->flagFloor,g->flagX,g->flagY);
+    for(int i=0;i<g->playerCount;++i){
         const Player* p=&g->players[i];
         printf("P%d F%d (%d,%d) %s MP:%d %s\n", i,p->floor,p->x,p->y, p->inMaze?dir_name(p->dir):"START", p->movementPoints, p->inMaze?"":"(waiting)");
     }
@@ -262,35 +491,175 @@ void game_print_help(){
     puts("Commands: (not interactive yet)");
 }
 
-void game_round_end(Game* g){
+ENGINE_INLINE void round_end(Game* g, unsigned v){
+    PROFILE_BEGIN(PROF_ROUND_END);
+    EMIT_V(v,g,.type=GAME_EVENT_ROUND,.player=-1,.value=g->roundNumber);
     g->stairDirectionChangeCountdown--;
     if(g->stairDirectionChangeCountdown<=0){
+        PROFILE_BEGIN(PROF_STAIR_CYCLE);
         g->stairDirectionChangeCountdown = g->config.stairCycleRounds;
         g->totalStairCycles++;
         // Determine global mode
         bool upMode = true;
-        if(g->config.alternateDirections){ upMode = (g->totalStairCycles % 2)==1; } else { upMode = (lcg(&g->rng)&1u)==0; }
-        for(int i=0;i<g->maze.stairCount;++i){
-            Stair* s=&g->maze.stairs[i];
-            if(g->config.forceOneWay){
-                s->bidirectional=false;
-                if(upMode){ s->enabledUp=true; s->enabledDown=false; }
-                else { s->enabledUp=false; s->enabledDown=true; }
-            } else {
+        if(v&VAR_ALTERNATE){ upMode = (g->totalStairCycles % 2)==1; } else { upMode = !rng_bit(&g->rng); }
+        for(int i=0;i<g->board->maze.stairCount;++i){
+            uint64_t bit = 1ull<<(i&63);
+            uint64_t* upWord=&g->stairUp[i>>6]; uint64_t* downWord=&g->stairDown[i>>6];
+            bool up, down;
+            if(v&VAR_ONE_WAY){ up=upMode; down=!upMode; }
+            else {
                 // Random toggling preserving potential bidirectionality
-                if((lcg(&g->rng)&1u)==0){ s->enabledUp=true; s->enabledDown=true; s->bidirectional=true; }
-                else { s->bidirectional=false; if((lcg(&g->rng)&1u)==0){ s->enabledUp=true; s->enabledDown=false; } else { s->enabledUp=false; s->enabledDown=true; } }
+                if(!rng_bit(&g->rng)){ up=true; down=true; }
+                else if(!rng_bit(&g->rng)){ up=true; down=false; } else { up=false; down=true; }
             }
+            *upWord = up ? (*upWord|bit) : (*upWord&~bit);
+            *downWord = down ? (*downWord|bit) : (*downWord&~bit);
         }
-        printf("[Stair cycle %u -> %s]\n", g->totalStairCycles, upMode?"UP":"DOWN");
+        EMIT_V(v,g,.type=GAME_EVENT_STAIR_CYCLE,.player=-1,.other=upMode,.value=(int)g->totalStairCycles);
+        PROFILE_END(PROF_STAIR_CYCLE);
     }
+    PROFILE_END(PROF_ROUND_END);
+}
+
+static unsigned variant_bits(const Game* g){
+    return (GAME_EMITS(g)?VAR_EMITS:0u) | (g->chooseDirection?VAR_CHOOSER:0u) | (g->config.forceOneWay?VAR_ONE_WAY:0u) | (g->config.alternateDirections?VAR_ALTERNATE:0u);
 }
 
+struct GameEngine {
+    bool (*takeTurn)(Game* g, PlayerId pid);
+    bool (*resumeTurn)(Game* g, PlayerId pid, int moveDie);
+    void (*roundEnd)(Game* g);
+};
+
+#define ENGINE_VARIANT(name,v) \
+    static bool take_turn_##name(Game* g, PlayerId pid){ return take_turn(g,pid,v); } \
+    static bool resume_turn_##name(Game* g, PlayerId pid, int moveDie){ return resume_turn(g,pid,moveDie,v); } \
+    static void round_end_##name(Game* g){ round_end(g,v); }
+ENGINE_VARIANT(0,0u)  ENGINE_VARIANT(1,1u)  ENGINE_VARIANT(2,2u)  ENGINE_VARIANT(3,3u)
+ENGINE_VARIANT(4,4u)  ENGINE_VARIANT(5,5u)  ENGINE_VARIANT(6,6u)  ENGINE_VARIANT(7,7u)
+ENGINE_VARIANT(8,8u)  ENGINE_VARIANT(9,9u)  ENGINE_VARIANT(10,10u) ENGINE_VARIANT(11,11u)
+ENGINE_VARIANT(12,12u) ENGINE_VARIANT(13,13u) ENGINE_VARIANT(14,14u) ENGINE_VARIANT(15,15u)
+// The generic engine reads the bits from the game on every call: the path every game took before
+ENGINE_VARIANT(generic,variant_bits(g))
+#undef ENGINE_VARIANT
+#define ENGINE_ENTRY(v) { take_turn_##v, resume_turn_##v, round_end_##v }
+
+static const GameEngine engines[VAR_COUNT+1]={
+    ENGINE_ENTRY(0),  ENGINE_ENTRY(1),  ENGINE_ENTRY(2),  ENGINE_ENTRY(3),  ENGINE_ENTRY(4),  ENGINE_ENTRY(5),
+    ENGINE_ENTRY(6),  ENGINE_ENTRY(7),  ENGINE_ENTRY(8),  ENGINE_ENTRY(9),  ENGINE_ENTRY(10), ENGINE_ENTRY(11),
+    ENGINE_ENTRY(12), ENGINE_ENTRY(13), ENGINE_ENTRY(14), ENGINE_ENTRY(15), ENGINE_ENTRY(generic) };
+
+static void select_engine(Game* g){ g->engine=&engines[variant_bits(g)]; }
+void game_use_generic_engine(Game* g){ g->engine=&engines[VAR_COUNT]; }
+
+bool game_take_turn(Game* g, PlayerId pid){
+    PROFILE_BEGIN(PROF_TURN);
+    bool won=g->engine->takeTurn(g,pid);
+    PROFILE_END(PROF_TURN);
+    return won;
+}
+
+bool game_resume_turn(Game* g, PlayerId pid, int moveDie){ return g->engine->resumeTurn(g,pid,moveDie); }
+void game_round_end(Game* g){ g->engine->roundEnd(g); }
+
 void game_print_summary(const Game* g){
     puts("=== Game Summary ===");
     printf("Rounds: %d  Stair Cycles: %u\n", g->roundNumber, g->totalStairCycles);
-    for(int i=0;i<PLAYER_COUNT;++i){
+    for(int i=0;i<g->playerCount;++i){
         const Player* p=&g->players[i];
         printf("P%d Steps:%u Captures:%u Captured:%u Bawana:%u MP:%d\n", i,p->stepsMoved,p->capturesDone,p->timesCaptured,p->bawanaVisits,p->movementPoints);
     }
 }
+
+void game_set_sink(Game* g, GameEventSink sink, void* user){ g->sink=sink; g->sinkUser=user; select_engine(g); }
+void game_set_chooser(Game* g, GameDirectionChooser chooser, void* user){ g->chooseDirection=chooser; g->chooserUser=user; select_engine(g); }
+
+void game_print_event(const GameEvent* ev, void* user){
+    (void)user;
+    switch(ev->type){
+        case GAME_EVENT_ENTER: printf("Player %d enters maze at (%d,%d)\n", ev->player, ev->x, ev->y); break;
+        case GAME_EVENT_SKIP: printf("Player %d skips (remaining %d)\n", ev->player, ev->value); break;
+        case GAME_EVENT_MP_DEPLETED: printf("Movement points depleted -> Bawana\n"); break;
+        case GAME_EVENT_BAWANA:
+            switch(ev->value){
+                case 0: printf("Bawana effect: Food Poisoning (skip 3).\n"); break;
+                case 1: printf("Bawana effect: Disoriented (random 4 turns +50 MP).\n"); break;
+                case 2: printf("Bawana effect: Triggered (+50 MP double speed).\n"); break;
+                case 3: printf("Bawana effect: Happy (+200 MP).\n"); break;
+                case 4: printf("Bawana effect: Bonus MP random.\n"); break;
+            }
+            break;
+        case GAME_EVENT_CAPTURE: printf("Player %d captured player %d!\n", ev->player, ev->other); break;
+        case GAME_EVENT_FLAG:
+            if(ev->value) printf("Player %d captured the flag on entry! Game Over.\n", ev->player);
+            else printf("Player %d captured the flag! Game Over.\n", ev->player);
+            break;
+        case GAME_EVENT_AI_DIRECTION: printf("Player %d AI picks direction %s\n", ev->player, dir_name((Direction)ev->value)); break;
+        case GAME_EVENT_STAIR_CYCLE: printf("[Stair cycle %d -> %s]\n", ev->value, ev->other?"UP":"DOWN"); break;
+        default: break; // per-step detail is for structured sinks (event log), not the console
+    }
+}
+
+const char* game_result_text(int result){
+    switch(result){
+        case GAME_RESULT_UNWINNABLE: return "flag unreachable";
+        case GAME_RESULT_STALLED: return "all players stuck";
+        case GAME_RESULT_CAPPED: return "round cap";
+        default: return result>=0 ? "flag captured" : "unknown";
+    }
+}
+
+bool game_flag_reachable(const Game* g){
+    const Maze* m=&g->board->maze;
+    return maze_in_bounds(m,g->flagFloor,g->flagX,g->flagY) && (m->cells[maze_cell_index(m,g->flagFloor,g->flagX,g->flagY)]&CELL_REACHABLE);
+}
+
+// With MP <= 0 a move ends before its first step, and only poisoning running out (a fresh Bawana
+// effect) brings MP back. So once no player has MP or poisoning left, all that can happen is players
+// entering at their entry cells and capturing whoever stands there, which ends the game only if the
+// flag is on one of those cells or under a player.
+bool game_stalled(const Game* g){
+    for(int i=0;i<g->playerCount;++i){
+        const Player* p=&g->players[i];
+        const MazeStart* s=player_start(g,i);
+        if(p->movementPoints>0 || p->skipTurns>0) return false;
+        if(p->inMaze && p->floor==g->flagFloor && p->x==g->flagX && p->y==g->flagY) return false;
+        if(s->floor==g->flagFloor && s->entryX==g->flagX && s->entryY==g->flagY) return false;
+    }
+    return true;
+}
+
+void game_watch_init(GameWatch* w, const Game* g){ w->nextRound=g->roundNumber; }
+
+int game_watch_check(GameWatch* w, const Game* g){
+    if(g->roundNumber < w->nextRound) return 0;
+    if(!game_flag_reachable(g)) return GAME_RESULT_UNWINNABLE;
+    w->nextRound=g->roundNumber+GAME_WATCH_INTERVAL;
+    return game_stalled(g) ? GAME_RESULT_STALLED : 0;
+}
+
+int game_play(Game* g, int maxRounds){
+    GameWatch w; game_watch_init(&w,g);
+    while(g->roundNumber < maxRounds){
+        int stop=game_watch_check(&w,g);
+        if(stop) return stop;
+        for(int p=0;p<g->playerCount;++p){
+            if(game_take_turn(g,(PlayerId)p)) return p;
+        }
+        g->roundNumber++;
+        game_round_end(g);
+    }
+    return -1;
+}
+
+// Hot-path entry points for benchmarks and tools; same behavior as inside game_take_turn
+void game_move_player(Game* g, PlayerId pid, int steps){
+    Player* p=&g->players[pid]; int32_t from=player_cell(g,p);
+    perform_move(g,p,steps,false,variant_bits(g));
+    if(p->inMaze) occ_move(g,pid,from,player_cell(g,p));
+}
+void game_resolve_teleport(Game* g, PlayerId pid){
+    Player* p=&g->players[pid]; int32_t from=player_cell(g,p);
+    resolve_stair_or_pole(g,p,false,variant_bits(g));
+    if(p->inMaze) occ_move(g,pid,from,player_cell(g,p));
+}
@@ -1,23 +1,266 @@
 #include "game.h"
+#include "sweep.h"
+#include "ai.h"
+#include "checkpoint.h"
+#include "eventlog.h"
+#include "profile.h"
+#include "render.h"
+#include "server.h"
+#include "tune.h"
+#include "shard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
+static Maze layout; // from --maze, shared by every board built in this process
+
+static int load_layout(const char* path){
+    char err[256];
+    if(maze_load_file(&layout,path,err,sizeof err)!=0){ fprintf(stderr,"cannot load maze %s: %s\n", path, err); return -1; }
+    return 0;
+}
+
+// --profile <file> [--profile-hz N]: per-phase engine counters, JSON or CSV (.csv) at exit
+static int profile_begin(const char* path, int hz){
+    if(!path) return 0;
+    if(!profile_enabled()){ fprintf(stderr,"--profile needs a build with the engine counters (make PROFILE=1)\n"); return -1; }
+    if(profile_start(hz)!=0){ fprintf(stderr,"cannot start the profile sampler\n"); return -1; }
+    return 0;
+}
+
+static void profile_finish(const char* path){
+    if(!path) return;
+    ProfileReport r; profile_stop(&r);
+    if(profile_write(&r,path)!=0) fprintf(stderr,"cannot write profile %s\n", path);
+}
+
+// --procs: the sweep's seeds split over forked worker processes, saved for resuming with --resume-file
+static int run_shard(const SweepOptions* opt, ShardOptions* shard, const char* profilePath){
+    if(opt->eventLogPath || opt->statsPath || opt->boards || profilePath){
+        fprintf(stderr,"--procs and --resume-file sweep without --event-log, --stats, --boards or --profile\n"); maze_free(&layout); return 1;
+    }
+    shard->maxRounds=opt->maxRounds; shard->players=opt->players; shard->layout=opt->layout; shard->batch=opt->batch;
+    if(!shard->procs) shard->procs=opt->threads;
+    SweepStats stats;
+    time_t t0=time(NULL);
+    int rc=shard_run(shard,&stats);
+    maze_free(&layout);
+    if(rc<0){ fprintf(stderr,"sweep failed\n"); return 1; }
+    sweep_print(&stats,stdout);
+    fprintf(stderr,"[sweep wall time %.0fs]\n", difftime(time(NULL),t0));
+    return rc;
+}
+
+// maze_game --sweep <from> <to> [--threads N] [--max-rounds R] [--event-log <file>] [--maze <file>] [--batch] [--players N] [--profile <file>] [--profile-hz N]
+//               [--stats <file>] [--stats-rounds] [--boards N] [--board-cache N]
+//               [--procs N [--chunk N] [--resume-file <file>] [--save-sec S]]   (forked workers, resumable)
+static int run_sweep(int argc, char** argv){
+    if(argc<4){ fprintf(stderr,"usage: %s --sweep <from> <to> [--threads N] [--max-rounds R] [--event-log <file>] [--maze <file>] [--batch] [--players N] [--profile <file>] [--profile-hz N] [--stats <file>] [--stats-rounds] [--boards N] [--board-cache N] [--procs N [--chunk N] [--resume-file <file>] [--save-sec S]]\n", argv[0]); return 1; }
+    SweepOptions opt = { (unsigned)strtoul(argv[2],NULL,10), (unsigned)strtoul(argv[3],NULL,10), 0, 200000, NULL, NULL, false, GAME_DEFAULT_PLAYERS, NULL, false, 0, 0, NULL };
+    const char* profilePath = NULL; int profileHz = 0;
+    ShardOptions shard = { opt.fromSeed, opt.toSeed, 0, 0, 0, 0, NULL, false, NULL, 0 };
+    for(int i=4;i<argc;++i){
+        if(strcmp(argv[i],"--threads")==0 && i+1<argc) opt.threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--max-rounds")==0 && i+1<argc) opt.maxRounds=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--event-log")==0 && i+1<argc) opt.eventLogPath=argv[++i];
+        else if(strcmp(argv[i],"--maze")==0 && i+1<argc){ if(load_layout(argv[++i])!=0) return 1; opt.layout=&layout; }
+        else if(strcmp(argv[i],"--batch")==0) opt.batch=true;
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc) opt.players=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--profile")==0 && i+1<argc) profilePath=argv[++i];
+        else if(strcmp(argv[i],"--profile-hz")==0 && i+1<argc) profileHz=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--stats")==0 && i+1<argc) opt.statsPath=argv[++i];
+        else if(strcmp(argv[i],"--stats-rounds")==0) opt.statsRounds=true;
+        else if(strcmp(argv[i],"--boards")==0 && i+1<argc) opt.boards=(unsigned)strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--board-cache")==0 && i+1<argc) opt.boardCache=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--procs")==0 && i+1<argc) shard.procs=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--chunk")==0 && i+1<argc) shard.chunk=(unsigned)strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--resume-file")==0 && i+1<argc) shard.savePath=argv[++i];
+        else if(strcmp(argv[i],"--save-sec")==0 && i+1<argc) shard.saveSeconds=atoi(argv[++i]);
+        else { fprintf(stderr,"unknown sweep option: %s\n", argv[i]); return 1; }
+    }
+    if(profilePath && opt.batch){ fprintf(stderr,"--profile counts the default engine; ignoring --batch\n"); opt.batch=false; }
+    if(profile_begin(profilePath,profileHz)!=0) return 1;
+    if(opt.statsRounds && !opt.statsPath){ fprintf(stderr,"--stats-rounds needs --stats <file>\n"); return 1; }
+    if(shard.procs || shard.savePath) return run_shard(&opt,&shard,profilePath);
+    SweepStats stats;
+    clock_t t0=clock();
+    int rc=sweep_run(&opt,&stats);
+    profile_finish(profilePath);
+    maze_free(&layout);
+    if(rc!=0){ fprintf(stderr,"sweep failed\n"); return 1; }
+    sweep_print(&stats,stdout);
+    fprintf(stderr,"[sweep cpu time %.2fs]\n", (double)(clock()-t0)/CLOCKS_PER_SEC);
+    return 0;
+}
+
+// maze_game --serve <socket> [--sessions N] [--tick-ms M] [--turns-per-tick K] [--max-rounds R] [--maze <file>]
+static int run_serve(int argc, char** argv){
+    if(argc<3){ fprintf(stderr,"usage: %s --serve <socket> [--sessions N] [--tick-ms M] [--turns-per-tick K] [--max-rounds R] [--maze <file>] [--players N]\n", argv[0]); return 1; }
+    ServerOptions opt = { argv[2], SERVER_DEFAULT_SESSIONS, SERVER_DEFAULT_TICK_MS, SERVER_DEFAULT_TURNS_PER_TICK, 200000, NULL, GAME_DEFAULT_PLAYERS };
+    for(int i=3;i<argc;++i){
+        if(strcmp(argv[i],"--sessions")==0 && i+1<argc) opt.sessions=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--tick-ms")==0 && i+1<argc) opt.tickMs=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--turns-per-tick")==0 && i+1<argc) opt.turnsPerTick=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--max-rounds")==0 && i+1<argc) opt.maxRounds=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--maze")==0 && i+1<argc){ if(load_layout(argv[++i])!=0) return 1; opt.layout=&layout; }
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc) opt.players=atoi(argv[++i]);
+        else { fprintf(stderr,"unknown serve option: %s\n", argv[i]); return 1; }
+    }
+    int rc=server_run(&opt);
+    maze_free(&layout);
+    return rc==0 ? 0 : 1;
+}
+
+// maze_game --tune <fromSeed> [--stair-cycle 3,5,8] [--one-way 0,1] [--alternate 0,1] [--effects 25/35/25/10,...] [--threads N]
+//               [--max-rounds R] [--players N] [--maze <file>] [--batch-games N] [--min-games N] [--max-games N] [--z Z]
+//               [--balance-eps E] [--length-eps F] [--target-rounds T]
+static int run_tune(int argc, char** argv){
+    if(argc<3){ fprintf(stderr,"usage: %s --tune <fromSeed> [--stair-cycle 3,5,8] [--one-way 0,1] [--alternate 0,1] [--effects 25/35/25/10,...] [--threads N] [--max-rounds R] [--players N] [--maze <file>] [--batch-games N] [--min-games N] [--max-games N] [--z Z] [--balance-eps E] [--length-eps F] [--target-rounds T]\n", argv[0]); return 1; }
+    TuneOptions opt = { (unsigned)strtoul(argv[2],NULL,10), 0, 5000, GAME_DEFAULT_PLAYERS, NULL, 200, 400, 20000, 1.96, 0.03, 0.03, 0 };
+    TuneGrid grid; memset(&grid,0,sizeof grid);
+    bool bad=false;
+    for(int i=3;i<argc && !bad;++i){
+        if(strcmp(argv[i],"--stair-cycle")==0 && i+1<argc) bad=(grid.stairCycles=tune_parse_list(argv[++i],grid.stairCycle,TUNE_MAX_VALUES))<=0;
+        else if(strcmp(argv[i],"--one-way")==0 && i+1<argc) bad=(grid.oneWays=tune_parse_list(argv[++i],grid.oneWay,2))<=0;
+        else if(strcmp(argv[i],"--alternate")==0 && i+1<argc) bad=(grid.alternates=tune_parse_list(argv[++i],grid.alternate,2))<=0;
+        else if(strcmp(argv[i],"--effects")==0 && i+1<argc) bad=tune_parse_effects(argv[++i],&grid)!=0;
+        else if(strcmp(argv[i],"--threads")==0 && i+1<argc) opt.threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--max-rounds")==0 && i+1<argc) opt.maxRounds=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc) opt.players=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--maze")==0 && i+1<argc){ if(load_layout(argv[++i])!=0) return 1; opt.layout=&layout; }
+        else if(strcmp(argv[i],"--batch-games")==0 && i+1<argc) opt.batchGames=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--min-games")==0 && i+1<argc) opt.minGames=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--max-games")==0 && i+1<argc) opt.maxGames=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--z")==0 && i+1<argc) opt.z=atof(argv[++i]);
+        else if(strcmp(argv[i],"--balance-eps")==0 && i+1<argc) opt.balanceEps=atof(argv[++i]);
+        else if(strcmp(argv[i],"--length-eps")==0 && i+1<argc) opt.lengthEps=atof(argv[++i]);
+        else if(strcmp(argv[i],"--target-rounds")==0 && i+1<argc) opt.targetRounds=atof(argv[++i]);
+        else { fprintf(stderr,"unknown tune option: %s\n", argv[i]); return 1; }
+        if(bad) fprintf(stderr,"bad value for %s: %s\n", argv[i-1], argv[i]);
+    }
+    if(bad) return 1;
+    clock_t t0=clock();
+    TuneReport report;
+    int rc=tune_run(&opt,&grid,&report);
+    maze_free(&layout);
+    if(rc!=0){ fprintf(stderr,"tuning failed\n"); tune_report_free(&report); return 1; }
+    tune_print(&report,stdout);
+    tune_report_free(&report);
+    fprintf(stderr,"[tune cpu time %.2fs]\n", (double)(clock()-t0)/CLOCKS_PER_SEC);
+    return 0;
+}
+
 int main(int argc, char** argv){
+    if(argc>1 && strcmp(argv[1],"--sweep")==0) return run_sweep(argc,argv);
+    if(argc>1 && strcmp(argv[1],"--tune")==0) return run_tune(argc,argv);
+    if(argc>1 && strcmp(argv[1],"--serve")==0) return run_serve(argc,argv);
     unsigned seed = (unsigned)time(NULL);
-    if(argc>1) seed = (unsigned)strtoul(argv[1],NULL,10);
-    Game g; game_init(&g,seed);
-    if(argc>2 && strcmp(argv[2],"fastflag")==0){
-        g.maze.flagFloor=0; g.maze.flagX=5; g.maze.flagY=12; // adjacent to Player A's entry path
-        printf("[FastFlag mode active: flag set to F0 (5,12)]\n");
-    }
-    printf("=====Maze Runner UCSC (seed %u)=====By Dilki ishara=====\n", seed);
-    game_print_status(&g);
-    int winner=-1;
+    static Board board;
+    Game g = {0};
+    Checkpoint resume = {0};
+    int argi = 2;
+    if(argc>2 && strcmp(argv[1],"--resume")==0){
+        // maze_game --resume <file> [round] [options]: continue from a snapshot (last one by default)
+        if(checkpoint_map(&resume,argv[2])!=0 || resume.count==0){ fprintf(stderr,"cannot read checkpoint %s\n", argv[2]); return 1; }
+        int64_t index = (int64_t)resume.count-1;
+        argi = 3;
+        if(argc>3 && argv[3][0]!='-'){
+            index = checkpoint_find_round(&resume,atoi(argv[3])); argi = 4;
+            if(index<0){ fprintf(stderr,"round %s not in checkpoint\n", argv[3]); return 1; }
+        }
+        if(checkpoint_restore(&resume,(uint64_t)index,&g)!=0){ fprintf(stderr,"cannot restore checkpoint %s (corrupt record or out of memory)\n", argv[2]); return 1; }
+        seed = resume.header->diceSeed;
+        printf("[Resumed from %s at round %d]\n", argv[2], g.roundNumber);
+    } else {
+        if(argc>1) seed = (unsigned)strtoul(argv[1],NULL,10);
+        if(!seed) seed=(unsigned)time(NULL);
+        // --maze replaces the built-in layout and --board-seed the board's seed (the dice keep <seed>);
+        // a resumed game always uses the board stored in its checkpoint
+        const char* mazePath=NULL;
+        unsigned boardSeed=seed;
+        for(int i=argi;i+1<argc;++i){
+            if(strcmp(argv[i],"--maze")==0) mazePath=argv[i+1];
+            else if(strcmp(argv[i],"--board-seed")==0) boardSeed=(unsigned)strtoul(argv[i+1],NULL,10);
+        }
+        if(!mazePath) board_init(&board,boardSeed);
+        else if(load_layout(mazePath)!=0) return 1;
+        else if(board_init_from_layout(&board,&layout,boardSeed)!=0){ fprintf(stderr,"out of memory\n"); return 1; }
+        game_init_from_board(&g,&board,seed);
+    }
+    // Options: fastflag, --ai <players e.g. AC>, --rollouts N, --budget-ms M, --ai-threads T, --horizon R, --checkpoint <file>,
+    // --event-log <file>, --maze <file>, --board-seed S, --players N (new games only; up to GAME_MAX_PLAYERS), --profile <file>, --profile-hz N,
+// --watch [fps] (live board instead of the turn log), --tps N (turns per second while watching)
+    AiConfig aiCfg = { 64, 50.0, 300, 0, 0 };
+    unsigned aiMask = 0;
+    const char* checkpointPath = NULL;
+    const char* eventLogPath = NULL;
+    const char* profilePath = NULL; int profileHz = 0;
+    int watchFps = -1, watchTps = 0; // -1 = no live board
+    for(int i=argi;i<argc;++i){
+        if(strcmp(argv[i],"fastflag")==0){
+            g.flagFloor=0; g.flagX=5; g.flagY=12; // adjacent to Player A's entry path
+            printf("[FastFlag mode active: flag set to F0 (5,12)]\n");
+        }
+        else if(strcmp(argv[i],"--ai")==0 && i+1<argc){
+            for(const char* c=argv[++i];*c;++c) if(*c>='A' && *c<='Z') aiMask |= 1u<<(*c-'A'); // letters beyond the player count are ignored
+        }
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc && !resume.base){
+            if(game_set_players(&g,atoi(argv[++i]))!=0){ fprintf(stderr,"--players takes 1..%d\n", GAME_MAX_PLAYERS); return 1; }
+        }
+        else if(strcmp(argv[i],"--rollouts")==0 && i+1<argc) aiCfg.rollouts=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--budget-ms")==0 && i+1<argc) aiCfg.budgetMs=atof(argv[++i]);
+        else if(strcmp(argv[i],"--ai-threads")==0 && i+1<argc) aiCfg.threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--horizon")==0 && i+1<argc) aiCfg.horizonRounds=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--checkpoint")==0 && i+1<argc) checkpointPath=argv[++i];
+        else if(strcmp(argv[i],"--event-log")==0 && i+1<argc) eventLogPath=argv[++i];
+        else if(strcmp(argv[i],"--profile")==0 && i+1<argc) profilePath=argv[++i];
+        else if(strcmp(argv[i],"--profile-hz")==0 && i+1<argc) profileHz=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--watch")==0){
+            watchFps = (i+1<argc && argv[i+1][0]>='0' && argv[i+1][0]<='9') ? atoi(argv[++i]) : 30;
+            game_set_sink(&g,NULL,NULL); // the board replaces the event text
+        }
+        else if(strcmp(argv[i],"--tps")==0 && i+1<argc) watchTps=atoi(argv[++i]);
+        else if((strcmp(argv[i],"--maze")==0 || strcmp(argv[i],"--board-seed")==0) && i+1<argc) ++i; // handled above
+        else { fprintf(stderr,"unknown option: %s\n", argv[i]); return 1; }
+    }
+    AiPool* ai = NULL;
+    if(aiMask){
+        aiCfg.players = g.playerCount;
+        ai = ai_pool_create(&aiCfg);
+        if(!ai){ fprintf(stderr,"failed to create AI pool\n"); return 1; }
+        ai_attach(&g,ai,aiMask);
+    }
+    // Snapshot at the start of every round, appended to one file (resumed runs keep appending)
+    CheckpointWriter ckpt = {0};
+    if(checkpointPath && (checkpoint_writer_open(&ckpt,checkpointPath,&g,resume.base!=NULL)!=0 ||
+                          (resume.base && checkpoint_writer_rewind(&ckpt,g.roundNumber)!=0))){
+        fprintf(stderr,"cannot write checkpoint %s\n", checkpointPath); return 1;
+    }
+    // Binary copy of every engine event; console output still goes through the chained print sink
+    EventLogFile logFile; EventLog log = {0};
+    if(eventLogPath){
+        if(eventlog_file_open(&logFile,eventLogPath)!=0 || eventlog_init(&log,&logFile,0)!=0){
+            fprintf(stderr,"cannot write event log %s\n", eventLogPath); return 1;
+        }
+        eventlog_begin_game(&log,seed,g.playerCount);
+        eventlog_attach(&log,&g);
+    }
+    if(profile_begin(profilePath,profileHz)!=0) return 1;
+    Renderer view; bool watching = watchFps>=0;
+    if(watching && render_init(&view,stdout,&g,watchFps,watchTps)!=0){ fprintf(stderr,"out of memory\n"); return 1; }
+    if(watching) render_frame(&view,&g,true);
+    else if(g.board->seed==seed) printf("=====Maze Runner UCSC (seed %u)=====By Dilki ishara=====\n", seed);
+    else printf("=====Maze Runner UCSC (seed %u, board %u)=====By Dilki ishara=====\n", seed, g.board->seed);
+    if(!watching) game_print_status(&g);
+    int winner=GAME_RESULT_CAPPED, stop;
     int maxRounds = 200000; // large safety cap
+    GameWatch watch; game_watch_init(&watch,&g);
     while(winner<0 && g.roundNumber < maxRounds){
-        for(int p=0;p<PLAYER_COUNT && winner<0;++p){
+        if((stop=game_watch_check(&watch,&g))!=0){ winner=stop; break; }
+        if(ckpt.f) checkpoint_append(&ckpt,&g);
+        for(int p=0;p<g.playerCount && winner<0;++p){
+            if(watching){ if(game_take_turn(&g,(PlayerId)p)) winner=p; render_turn(&view,&g); continue; }
             printf("-- Player %d turn --\n", p);
             if(game_take_turn(&g,(PlayerId)p)) winner=p;
             game_print_status(&g);
@@ -26,7 +269,23 @@ int main(int argc, char** argv){
         g.roundNumber++;
         game_round_end(&g);
     }
-        if(winner>=0) printf("Winner: Player %d\n", winner); else printf("No winner within %d rounds (flag uncaptured).\n", g.roundNumber);
+    if(watching){ render_frame(&view,&g,true); render_free(&view); }
+        if(winner>=0) printf("Winner: Player %d\n", winner);
+        else if(winner==GAME_RESULT_UNWINNABLE) printf("No winner: the flag at F%d (%d,%d) cannot be reached (stopped at round %d).\n", g.flagFloor, g.flagX, g.flagY, g.roundNumber);
+        else if(winner==GAME_RESULT_STALLED) printf("No winner: every player is out of movement points for good (stopped at round %d).\n", g.roundNumber);
+        else printf("No winner within %d rounds (flag uncaptured).\n", g.roundNumber);
         game_print_summary(&g);
-    return 0;
+    if(eventLogPath){
+        eventlog_end_game(&log,&g,winner);
+        eventlog_free(&log);
+        if(eventlog_file_close(&logFile)!=0) fprintf(stderr,"event log %s incomplete (write error)\n", eventLogPath);
+    }
+    ai_pool_destroy(ai);
+    profile_finish(profilePath);
+    checkpoint_writer_close(&ckpt);
+    game_free(&g);
+    checkpoint_unmap(&resume);
+    board_free(&board);
+    maze_free(&layout);
+    return winner==GAME_RESULT_UNWINNABLE ? 2 : winner==GAME_RESULT_STALLED ? 3 : 0; // early stops get their own exit status
 }
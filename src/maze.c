@@ -1,35 +1,295 @@
 #include "maze.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
 
-static unsigned lcg(unsigned *state){
-    *state = (*state * 1664525u + 1013904223u);
-    return *state;
-}
+// Same board as mazes/default.maze (comments stripped)
+const char maze_default_description[] =
+    "size 3 10 25\n"
+    "rect 0 0 0 9 24\n"
+    "rect 1 0 0 9 7\n"
+    "rect 1 0 16 9 23\n"
+    "rect 1 3 8 6 16\n"
+    "rect 2 0 8 9 16\n"
+    "stair 0 4 5 1 4 5\n"
+    "stair 1 4 10 2 4 10\n"
+    "pole 2 0 5 24\n"
+    "bawana 0 6 21 9 24 9 19\n"
+    "wall 0 6 20 9 20\n"
+    "wall 0 6 20 6 24\n"
+    "start 0 6 12 5 12 N\n"
+    "start 0 9 8 9 7 W\n"
+    "start 0 9 16 9 17 E\n"
+    "effects 25 35 25 10\n";
 
-bool maze_in_bounds(int f,int x,int y){
-    return f>=0 && f<FLOORS && x>=0 && x<WIDTH && y>=0 && y<LENGTH;
+bool maze_in_bounds(const Maze* m,int f,int x,int y){
+    return f>=0 && f<m->floors && x>=0 && x<m->width && y>=0 && y<m->length;
 }
 
 bool maze_cell_exists(const Maze* m,int f,int x,int y){
-    if(!maze_in_bounds(f,x,y)) return false;
-    return m->valid[f][x][y];
+    if(!maze_in_bounds(m,f,x,y)) return false;
+    return (m->cells[maze_cell_index(m,f,x,y)] & CELL_VALID)!=0;
 }
 
-int maze_random_effect_value(CellEffectType t, unsigned* rngState){
-    unsigned r = lcg(rngState);
+int maze_random_effect_value(CellEffectType t, Rng* rng){
     switch(t){
-        case CELL_EFFECT_CONSUME: return (int)(r%4)+1; // 1-4
-        case CELL_EFFECT_ADD: return (int)(r%5)+1; // 1-5
-        case CELL_EFFECT_MULTIPLY: return (r & 1)?2:3; // 2 or 3
+        case CELL_EFFECT_CONSUME: return (int)rng_bounded(rng,4)+1; // 1-4
+        case CELL_EFFECT_ADD: return (int)rng_bounded(rng,5)+1; // 1-5
+        case CELL_EFFECT_MULTIPLY: return rng_bit(rng)?2:3; // 2 or 3
         default: return 0;
     }
 }
 
+// Arena layout from the counts; assigns the array pointers when arena is non-NULL. Returns bytes needed.
+static size_t maze_layout(Maze* m, void* arena){
+    size_t off=0, teleports=2u*(size_t)m->stairCount+2u*(size_t)m->poleCount;
+    #define MAZE_SEGMENT(field,n) do{ off=(off+7u)&~(size_t)7u; if(arena) m->field=(void*)((char*)arena+off); off+=(size_t)(n)*sizeof *m->field; }while(0)
+    MAZE_SEGMENT(stairs,m->stairCount);
+    MAZE_SEGMENT(poles,m->poleCount);
+    MAZE_SEGMENT(teleportCells,teleports);
+    MAZE_SEGMENT(teleportCodes,teleports);
+    MAZE_SEGMENT(effects,m->cellCount);
+    MAZE_SEGMENT(cells,m->cellCount);
+    MAZE_SEGMENT(walls,m->cellCount);
+    MAZE_SEGMENT(bawanaTypes,m->bawanaArea);
+    MAZE_SEGMENT(runs,(size_t)m->cellCount*4u);
+    #undef MAZE_SEGMENT
+    return (off+63u)&~(size_t)63u;
+}
+
+// Counts and coordinates of an image read from a file: bounded before the arena is sized from them
+static bool maze_image_sane(const Maze* m){
+    if(m->floors<1 || m->width<1 || m->length<1 || m->floors>MAZE_MAX_DIM || m->width>MAZE_MAX_DIM || m->length>MAZE_MAX_DIM) return false;
+    uint64_t cells=(uint64_t)m->floors*(uint64_t)m->width*(uint64_t)m->length;
+    if(cells>MAZE_MAX_CELLS || (uint64_t)m->cellCount!=cells) return false;
+    if(m->stairCount<0 || m->stairCount>MAX_STAIRS || m->poleCount<0 || m->poleCount>m->cellCount) return false;
+    if(m->teleportCellCount<0 || m->teleportCellCount>2*(m->stairCount+m->poleCount)) return false;
+    const BawanaRegion* b=&m->bawana;
+    if(!maze_in_bounds(m,b->floor,b->xMin,b->yMin) || !maze_in_bounds(m,b->floor,b->xMax,b->yMax) || !maze_in_bounds(m,b->floor,b->entranceX,b->entranceY) ||
+       b->xMin>b->xMax || b->yMin>b->yMax || (int64_t)m->bawanaArea!=(int64_t)(b->xMax-b->xMin+1)*(b->yMax-b->yMin+1)) return false;
+    if(m->startCount<1 || m->startCount>MAZE_MAX_STARTS) return false;
+    for(int i=0;i<m->startCount;++i)
+        if(!maze_in_bounds(m,m->starts[i].floor,m->starts[i].entryX,m->starts[i].entryY) || m->starts[i].dir<0 || m->starts[i].dir>3) return false;
+    return maze_in_bounds(m,m->flagFloor,m->flagX,m->flagY);
+}
+
+// Arrays of an attached image: everything the engine indexes with stays inside the maze and the arena
+static bool maze_arrays_sane(const Maze* m){
+    for(int i=0;i<m->stairCount;++i){
+        const Stair* s=&m->stairs[i];
+        if(!maze_in_bounds(m,s->startFloor,s->startX,s->startY) || !maze_in_bounds(m,s->endFloor,s->endX,s->endY)) return false;
+    }
+    for(int i=0;i<m->poleCount;++i){
+        const Pole* p=&m->poles[i];
+        if(!maze_in_bounds(m,p->fromFloor,p->x,p->y) || !maze_in_bounds(m,p->toFloor,p->x,p->y)) return false;
+    }
+    // Teleport cells: strictly increasing, each marked CELL_TELEPORT and every marked cell listed
+    uint32_t codes=2u*(uint32_t)(m->stairCount+m->poleCount);
+    for(int i=0;i<m->teleportCellCount;++i){
+        const TeleportCell* t=&m->teleportCells[i];
+        if(t->cell>=(uint32_t)m->cellCount || (i>0 && t->cell<=m->teleportCells[i-1].cell) || !(m->cells[t->cell]&CELL_TELEPORT)) return false;
+        if(t->first>codes || t->count>codes-t->first) return false;
+        for(uint32_t k=0;k<t->count;++k){
+            uint32_t code=m->teleportCodes[t->first+k];
+            if(code<TELEPORT_POLE_BASE ? code>=2u*(uint32_t)m->stairCount : code-TELEPORT_POLE_BASE>=(uint32_t)m->poleCount) return false;
+        }
+    }
+    int marked=0;
+    for(int c=0;c<m->cellCount;++c){
+        marked += (m->cells[c]&CELL_TELEPORT)!=0;
+        // Open sides and straight runs must not lead off the floor
+        int x=(c/m->length)%m->width, y=c%m->length;
+        for(int d=0;d<4;++d){
+            int run=m->runs[c*4+d], reach = run>1 || !(m->cells[c]&(CELL_OPEN_N<<d)) ? run : 1;
+            int nx = x + (d==0 ? -reach : d==2 ? reach : 0), ny = y + (d==1 ? reach : d==3 ? -reach : 0);
+            if(run>MAZE_RUN_MAX || nx<0 || nx>=m->width || ny<0 || ny>=m->length) return false;
+        }
+    }
+    if(marked!=m->teleportCellCount) return false;
+    for(int i=0;i<m->bawanaArea;++i) if(m->bawanaTypes[i]<0 || m->bawanaTypes[i]>4) return false;
+    return true;
+}
+
+int maze_attach(Maze* m, void* arena, size_t size){
+    if(!maze_image_sane(m) || maze_layout(m,NULL)!=size) return -1;
+    m->arena=arena; m->arenaCapacity=0;
+    m->defaultLayout=false; m->scratch=(MazeScratch){NULL,0}; // the image's pointers belong to its writer
+    m->arenaSize=maze_layout(m,arena);
+    return maze_arrays_sane(m) ? 0 : -1;
+}
+
+// (Re)allocate m's arena for its current counts, zero-filled
+static int maze_alloc(Maze* m){
+    size_t size=maze_layout(m,NULL);
+    if(!m->arena || m->arenaCapacity<size){
+        if(m->arenaCapacity) free(m->arena);
+        m->arena=malloc(size); m->arenaCapacity = m->arena ? size : 0;
+        if(!m->arena) return -1;
+    }
+    memset(m->arena,0,size);
+    m->arenaSize=maze_layout(m,m->arena);
+    return 0;
+}
+
+void maze_free(Maze* m){
+    if(m->arenaCapacity) free(m->arena);
+    m->arena=NULL; m->arenaSize=0; m->arenaCapacity=0; m->defaultLayout=false;
+    free(m->scratch.base); m->scratch=(MazeScratch){NULL,0};
+}
+
+void* maze_scratch_reserve(MazeScratch* s, size_t bytes){
+    if(s->capacity<bytes){
+        void* grown=malloc(bytes);
+        if(!grown) return NULL;
+        free(s->base); s->base=grown; s->capacity=bytes;
+    }
+    return s->base;
+}
+
+int maze_copy(Maze* dst, const Maze* src){
+    void* arena=dst->arena; size_t cap=dst->arenaCapacity;
+    MazeScratch scratch=dst->scratch;
+    *dst=*src;
+    dst->arena=arena; dst->arenaCapacity=cap; dst->scratch=scratch;
+    if(maze_alloc(dst)!=0) return -1;
+    memcpy(dst->arena,src->arena,src->arenaSize);
+    return 0;
+}
+
+bool maze_equal(const Maze* a, const Maze* b){
+    if(a->floors!=b->floors || a->width!=b->width || a->length!=b->length || a->stairCount!=b->stairCount ||
+       a->poleCount!=b->poleCount || a->teleportCellCount!=b->teleportCellCount || a->bawanaArea!=b->bawanaArea ||
+       a->startCount!=b->startCount || a->flagFloor!=b->flagFloor || a->flagX!=b->flagX || a->flagY!=b->flagY ||
+       a->arenaSize!=b->arenaSize) return false;
+    if(memcmp(&a->bawana,&b->bawana,sizeof a->bawana)!=0 || memcmp(a->effectPercent,b->effectPercent,sizeof a->effectPercent)!=0) return false;
+    if(memcmp(a->starts,b->starts,sizeof(MazeStart)*(size_t)a->startCount)!=0) return false;
+    return memcmp(a->arena,b->arena,a->arenaSize)==0;
+}
+
+// Step table: bit d of a cell opens direction d when neither side of the shared edge carries a
+// wall and the target cell exists; the target itself is one stride away (see maze_cell_index).
+// Also refreshes the CELL_BAWANA markers.
+void maze_build_step_table(Maze* m){
+    static const int dx[4]={-1,0,1,0}, dy[4]={0,1,0,-1};
+    for(int f=0;f<m->floors;++f) for(int x=0;x<m->width;++x) for(int y=0;y<m->length;++y){
+        int c=maze_cell_index(m,f,x,y);
+        uint8_t open=0;
+        for(int d=0;d<4;++d){
+            int nx=x+dx[d], ny=y+dy[d];
+            if(!(m->walls[c] & (1u<<d)) && maze_cell_exists(m,f,nx,ny) && !(m->walls[maze_cell_index(m,f,nx,ny)] & (1u<<((d+2)%4))))
+                open |= (uint8_t)(CELL_OPEN_N<<d);
+        }
+        if(maze_is_bawana(m,f,x,y)) open |= CELL_BAWANA;
+        m->cells[c] = (uint8_t)((m->cells[c] & ~(CELL_OPEN_MASK|CELL_BAWANA)) | open);
+    }
+}
+
+// Layout only (effects are per seed), so it is built with the layout and copied with the arena
+void maze_build_run_table(Maze* m){
+    for(int c=0;c<m->cellCount;++c) for(int d=0;d<4;++d){
+        int len=0, delta=maze_dir_delta(m,d);
+        for(int cur=c; len<MAZE_RUN_MAX && (m->cells[cur]&(CELL_OPEN_N<<d)) && !(m->cells[cur+delta]&(CELL_TELEPORT|CELL_BAWANA)); cur+=delta) ++len;
+        m->runs[c*4+d]=(uint8_t)len;
+    }
+}
+
+static int teleport_cell_cmp(const void* a, const void* b){
+    uint32_t x=((const TeleportCell*)a)->cell, y=((const TeleportCell*)b)->cell;
+    return (x>y)-(x<y);
+}
+
+// Group every possible transition by cell so a game only checks its own stair enable bits
+void maze_build_teleport_table(Maze* m){
+    size_t cap=2u*(size_t)m->stairCount+2u*(size_t)m->poleCount;
+    uint32_t* cell = cap ? maze_scratch_reserve(&m->scratch,sizeof *cell*cap*2) : NULL;
+    if(cap && !cell){ m->teleportCellCount=0; return; }
+    uint32_t* code = cell+cap;
+    size_t n=0;
+    for(int i=0;i<m->stairCount;++i){
+        const Stair* s=&m->stairs[i];
+        if(maze_in_bounds(m,s->startFloor,s->startX,s->startY)){ cell[n]=(uint32_t)maze_cell_index(m,s->startFloor,s->startX,s->startY); code[n++]=2u*(uint32_t)i; }
+        if(maze_in_bounds(m,s->endFloor,s->endX,s->endY)){ cell[n]=(uint32_t)maze_cell_index(m,s->endFloor,s->endX,s->endY); code[n++]=2u*(uint32_t)i+1u; }
+    }
+    for(int i=0;i<m->poleCount;++i){
+        const Pole* pl=&m->poles[i];
+        for(int f=pl->fromFloor;f>=pl->fromFloor-1;--f)
+            if(maze_in_bounds(m,f,pl->x,pl->y)){ cell[n]=(uint32_t)maze_cell_index(m,f,pl->x,pl->y); code[n++]=TELEPORT_POLE_BASE+(uint32_t)i; }
+    }
+    for(int i=0;i<m->cellCount;++i) m->cells[i] &= (uint8_t)~CELL_TELEPORT;
+    uint32_t slots=0, used=0;
+    for(size_t i=0;i<n;++i){
+        if(m->cells[cell[i]] & CELL_TELEPORT) continue; // cell already grouped
+        TeleportCell* tc=&m->teleportCells[slots++]; tc->cell=cell[i]; tc->first=used; tc->count=0;
+        for(size_t j=i;j<n;++j) if(cell[j]==cell[i]){ m->teleportCodes[used++]=code[j]; tc->count++; }
+        m->cells[cell[i]] |= CELL_TELEPORT;
+    }
+    m->teleportCellCount=(int)slots;
+    qsort(m->teleportCells,slots,sizeof *m->teleportCells,teleport_cell_cmp);
+}
+
+const TeleportCell* maze_find_teleport(const Maze* m, int cell){
+    if(!(m->cells[cell] & CELL_TELEPORT)) return NULL;
+    size_t lo=0, hi=(size_t)m->teleportCellCount;
+    while(lo<hi){
+        size_t mid=lo+(hi-lo)/2;
+        if(m->teleportCells[mid].cell<(uint32_t)cell) lo=mid+1; else hi=mid;
+    }
+    return &m->teleportCells[lo];
+}
+
+// Reach markers: CELL_REACHABLE on every cell a player may stand on after a turn, for any dice and any
+// stair directions (the stair schedule enables each direction sooner or later). Entries and the
+// Bawana entrance (where MP depletion leads) seed the search; Bawana interior cells a move can end
+// on are marked but not expanded, since players only leave them for the entrance. A flag on an
+// unmarked cell can never be captured. Marks every cell when out of memory.
+static void reach_mark(Maze* m, uint32_t* queue, size_t* n, int f, int x, int y){
+    if(!maze_in_bounds(m,f,x,y)) return;
+    int c=maze_cell_index(m,f,x,y);
+    if(m->cells[c]&CELL_REACHABLE) return;
+    m->cells[c] |= CELL_REACHABLE;
+    if(!(m->cells[c]&CELL_BAWANA)) queue[(*n)++]=(uint32_t)c;
+}
+
+// A step in direction d arrived at (f,x,y) after any stair or pole; the interior bounces it back
+static void reach_arrive(Maze* m, uint32_t* queue, size_t* n, int d, int f, int x, int y){
+    static const int dx[4]={-1,0,1,0}, dy[4]={0,1,0,-1};
+    if(maze_is_bawana(m,f,x,y) && !maze_is_bawana_entrance(m,f,x-dx[d],y-dy[d])) reach_mark(m,queue,n,f,x-dx[d],y-dy[d]);
+    else reach_mark(m,queue,n,f,x,y);
+}
+
+void maze_build_reach_table(Maze* m){
+    static const int dx[4]={-1,0,1,0}, dy[4]={0,1,0,-1};
+    for(int i=0;i<m->cellCount;++i) m->cells[i] &= (uint8_t)~CELL_REACHABLE;
+    uint32_t* queue = m->cellCount ? maze_scratch_reserve(&m->scratch,sizeof *queue*(size_t)m->cellCount) : NULL;
+    if(!queue){ for(int i=0;i<m->cellCount;++i) m->cells[i] |= CELL_REACHABLE; return; }
+    size_t head=0, n=0;
+    for(int i=0;i<m->startCount;++i) reach_mark(m,queue,&n,m->starts[i].floor,m->starts[i].entryX,m->starts[i].entryY);
+    if(m->bawanaArea) reach_mark(m,queue,&n,m->bawana.floor,m->bawana.entranceX,m->bawana.entranceY);
+    while(head<n){
+        int c=(int)queue[head++];
+        int f=c/(m->width*m->length), x=c/m->length%m->width, y=c%m->length;
+        for(int d=0;d<4;++d){
+            if(!(m->cells[c] & (CELL_OPEN_N<<d))) continue;
+            int nx=x+dx[d], ny=y+dy[d];
+            const TeleportCell* tc=maze_find_teleport(m,maze_cell_index(m,f,nx,ny));
+            bool stays=true; // no pole: with every stair here disabled the step ends on the cell itself
+            for(uint32_t k=0; tc && k<tc->count; ++k){
+                uint32_t code=m->teleportCodes[tc->first+k];
+                if(code>=TELEPORT_POLE_BASE){ reach_arrive(m,queue,&n,d,m->poles[code-TELEPORT_POLE_BASE].toFloor,nx,ny); stays=false; break; }
+                const Stair* s=&m->stairs[code>>1];
+                if(code&1u) reach_arrive(m,queue,&n,d,s->startFloor,s->startX,s->startY);
+                else reach_arrive(m,queue,&n,d,s->endFloor,s->endX,s->endY);
+            }
+            if(stays) reach_arrive(m,queue,&n,d,f,nx,ny);
+        }
+    }
+}
+
 // Return new movement points after applying effect; consumed holds cost of consumables along path if needed
 int maze_apply_effect(const Maze* m,int f,int x,int y,int movementPoints,int* consumed){
     (void)consumed;
-    const CellEffect *ce = &m->effects[f][x][y];
+    const CellEffect *ce = &m->effects[maze_cell_index(m,f,x,y)];
     if(ce->type==CELL_EFFECT_CONSUME){
         return movementPoints - ce->value;
     } else if(ce->type==CELL_EFFECT_ADD){
@@ -40,101 +300,265 @@ int maze_apply_effect(const Maze* m,int f,int x,int y,int movementPoints,int* co
     return movementPoints;
 }
 
-static void mark_floor_layout(Maze* m){
-    // Default all invalid then mark existing according to description
-    for(int f=0; f<FLOORS; ++f){
-        for(int x=0;x<WIDTH;++x)
-            for(int y=0;y<LENGTH;++y)
-                m->valid[f][x][y]=false;
-    }
-    // Floor 0: width 10 length 25 all
-    for(int x=0;x<WIDTH;++x)
-        for(int y=0;y<LENGTH;++y)
-            m->valid[0][x][y]=true;
-    // Floor1: two rectangles 10x8 connected by bridge 4x9 above starting area (y positions?)
-    // Ambiguity: lacking exact coordinates; we assume first rectangle y:0-7, second rectangle y:16-23, bridge width x:3-6 y:7-15
-    for(int x=0;x<WIDTH;++x){
-        for(int y=0;y<8;++y) m->valid[1][x][y]=true;
-        for(int y=16;y<24;++y) m->valid[1][x][y]=true;
-    }
-    for(int x=3;x<7;++x)
-        for(int y=8;y<17;++y)
-            m->valid[1][x][y]=true;
-    // Floor2: rectangle 10x9 above standing area (assume y:8-16 x:0-9)
-    for(int x=0;x<WIDTH;++x)
-        for(int y=8;y<17;++y)
-            m->valid[2][x][y]=true;
-}
-
-void maze_init(Maze* m, unsigned seed){
-    m->stairCount=0; m->poleCount=0; m->flagFloor=0; m->flagX=0; m->flagY=0;
-    unsigned rng = seed;
-    mark_floor_layout(m);
-
-    // Clear walls
-    for(int f=0;f<FLOORS;++f)
-        for(int x=0;x<WIDTH;++x)
-            for(int y=0;y<LENGTH;++y)
-                m->walls[f][x][y]=0u;
-
-    // Exact quota distribution per Rule 10: 25% none, 35% consumables (1-4), 25% add (1-2), 10% add (3-5), 5% multipliers (2 or 3)
-    int total=0; for(int f=0;f<FLOORS;++f) for(int x=0;x<WIDTH;++x) for(int y=0;y<LENGTH;++y) if(m->valid[f][x][y]) ++total;
-    int quotaNone = (total*25)/100;
-    int quotaConsume = (total*35)/100;
-    int quotaAddSmall = (total*25)/100;
-    int quotaAddLarge = (total*10)/100;
-    int quotaMult = total - (quotaNone+quotaConsume+quotaAddSmall+quotaAddLarge); // remainder (multipliers quota)
-    // Fill list of coordinates
-    int cap = total; int *cx = malloc(sizeof(int)*cap); int *cy = malloc(sizeof(int)*cap); int *cf = malloc(sizeof(int)*cap); int idx=0;
-    for(int f=0;f<FLOORS;++f) for(int x=0;x<WIDTH;++x) for(int y=0;y<LENGTH;++y) if(m->valid[f][x][y]){ cf[idx]=f; cx[idx]=x; cy[idx]=y; idx++; }
-    // Shuffle
-    for(int i=cap-1;i>0;--i){ unsigned r = lcg(&rng)%(unsigned)(i+1); int tf=cf[i]; cf[i]=cf[r]; cf[r]=tf; int tx=cx[i]; cx[i]=cx[r]; cx[r]=tx; int ty=cy[i]; cy[i]=cy[r]; cy[r]=ty; }
-    idx=0;
-    for(int k=0;k<quotaNone && idx<cap;++k){ m->effects[cf[idx]][cx[idx]][cy[idx]]=(CellEffect){CELL_EFFECT_NONE,0}; idx++; }
-    for(int k=0;k<quotaConsume && idx<cap;++k){ m->effects[cf[idx]][cx[idx]][cy[idx]]=(CellEffect){CELL_EFFECT_CONSUME,(int)(lcg(&rng)%4)+1}; idx++; }
-    for(int k=0;k<quotaAddSmall && idx<cap;++k){ m->effects[cf[idx]][cx[idx]][cy[idx]]=(CellEffect){CELL_EFFECT_ADD,(int)(lcg(&rng)%2)+1}; idx++; }
-    for(int k=0;k<quotaAddLarge && idx<cap;++k){ m->effects[cf[idx]][cx[idx]][cy[idx]]=(CellEffect){CELL_EFFECT_ADD,(int)(lcg(&rng)%3)+3}; idx++; }
-    for(int k=0;idx<cap && k<quotaMult;++k,++idx){ m->effects[cf[idx]][cx[idx]][cy[idx]]=(CellEffect){CELL_EFFECT_MULTIPLY,(lcg(&rng)&1)?2:3}; }
-    free(cx); free(cy); free(cf);
-
-    // Stairs network: 0<->1 and 1<->2
-    if(m->stairCount < MAX_STAIRS){ // floor 0 to 1
-        m->stairs[m->stairCount++] = (Stair){0,4,5,1,4,5,true,true,true};
-    }
-    if(m->stairCount < MAX_STAIRS){ // floor 1 to 2
-        m->stairs[m->stairCount++] = (Stair){1,4,10,2,4,10,true,true,true};
-    }
-    if(m->poleCount < MAX_POLES){
-        m->poles[m->poleCount++] = (Pole){2,0,5,24};
-    }
-
-    // Random flag on existing cell (ensure reachable floor: any floor since connectivity provided)
-    while(1){
-        int f = (int)(lcg(&rng)%FLOORS);
-        int x = (int)(lcg(&rng)%WIDTH);
-        int y = (int)(lcg(&rng)%LENGTH);
-        if(m->valid[f][x][y]){ m->flagFloor=f; m->flagX=x; m->flagY=y; break; }
-    }
-
-    // Bawana walls (north wall from x=6..9 at y=20; west wall from y=20..24 at x=6)
-    maze_add_wall_line(m,0,6,20,9,20); // horizontal
-    maze_add_wall_line(m,0,6,20,6,24); // vertical
-}
-
-void maze_add_wall_line(Maze* m,int f,int x1,int y1,int x2,int y2){
+static void add_wall_line(Maze* m,int f,int x1,int y1,int x2,int y2){
     if(x1==x2){
         if(y2<y1){int t=y1; y1=y2; y2=t;}
         for(int y=y1;y<=y2;++y){
             if(maze_cell_exists(m,f,x1,y)){
-                if(y>y1 && maze_cell_exists(m,f,x1,y-1)){ m->walls[f][x1][y] |= CELL_WALL_N; m->walls[f][x1][y-1] |= CELL_WALL_S; }
+                if(y>y1 && maze_cell_exists(m,f,x1,y-1)){ m->walls[maze_cell_index(m,f,x1,y)] |= CELL_WALL_N; m->walls[maze_cell_index(m,f,x1,y-1)] |= CELL_WALL_S; }
             }
         }
     } else if(y1==y2){
         if(x2<x1){int t=x1; x1=x2; x2=t;}
         for(int x=x1;x<=x2;++x){
             if(maze_cell_exists(m,f,x,y1)){
-                if(x> x1 && maze_cell_exists(m,f,x-1,y1)){ m->walls[f][x][y1] |= CELL_WALL_W; m->walls[f][x-1][y1] |= CELL_WALL_E; }
+                if(x> x1 && maze_cell_exists(m,f,x-1,y1)){ m->walls[maze_cell_index(m,f,x,y1)] |= CELL_WALL_W; m->walls[maze_cell_index(m,f,x-1,y1)] |= CELL_WALL_E; }
             }
         }
     }
 }
+
+void maze_add_wall_line(Maze* m,int f,int x1,int y1,int x2,int y2){
+    add_wall_line(m,f,x1,y1,x2,y2);
+    m->defaultLayout=false;
+    maze_build_step_table(m);
+    maze_build_reach_table(m);
+    maze_build_run_table(m);
+}
+
+// ---- Description parser ----
+
+typedef struct {
+    const char* p;   // current position in the line
+    const char* end; // end of line (newline or comment excluded)
+    int line;
+    char* err;
+    size_t errSize;
+} MazeLine;
+
+static int parse_error(MazeLine* l, const char* fmt, ...){
+    if(l->err && l->errSize){
+        int n=snprintf(l->err,l->errSize,"line %d: ",l->line);
+        va_list ap; va_start(ap,fmt);
+        if(n>=0 && (size_t)n<l->errSize) vsnprintf(l->err+n,l->errSize-(size_t)n,fmt,ap);
+        va_end(ap);
+    }
+    return -1;
+}
+
+static bool next_word(MazeLine* l, const char** w, size_t* len){
+    while(l->p<l->end && (*l->p==' ' || *l->p=='\t' || *l->p=='\r')) l->p++;
+    if(l->p>=l->end) return false;
+    *w=l->p;
+    while(l->p<l->end && *l->p!=' ' && *l->p!='\t' && *l->p!='\r') l->p++;
+    *len=(size_t)(l->p-*w);
+    return true;
+}
+
+static bool word_is(const char* w, size_t len, const char* s){ return strlen(s)==len && memcmp(w,s,len)==0; }
+
+static int next_ints(MazeLine* l, int* out, int n){
+    for(int i=0;i<n;++i){
+        const char* w; size_t len; char buf[16];
+        if(!next_word(l,&w,&len)) return parse_error(l,"expected %d numbers",n);
+        if(len>=sizeof buf) return parse_error(l,"number too long");
+        memcpy(buf,w,len); buf[len]=0;
+        char* endp; long v=strtol(buf,&endp,10);
+        if(*endp || v<-MAZE_MAX_DIM || v>MAZE_MAX_DIM) return parse_error(l,"bad number '%s'",buf);
+        out[i]=(int)v;
+    }
+    return 0;
+}
+
+static int check_cell(MazeLine* l, const Maze* m, int f, int x, int y){
+    return maze_in_bounds(m,f,x,y) ? 0 : parse_error(l,"cell F%d (%d,%d) outside the %dx%dx%d board",f,x,y,m->floors,m->width,m->length);
+}
+
+static void mark_rect(Maze* m, const int* v, bool valid){
+    int x0=v[1]<v[3]?v[1]:v[3], x1=v[1]<v[3]?v[3]:v[1], y0=v[2]<v[4]?v[2]:v[4], y1=v[2]<v[4]?v[4]:v[2];
+    for(int x=x0;x<=x1;++x) for(int y=y0;y<=y1;++y){
+        uint8_t* c=&m->cells[maze_cell_index(m,v[0],x,y)];
+        *c = valid ? (uint8_t)(*c|CELL_VALID) : (uint8_t)(*c&~CELL_VALID);
+    }
+}
+
+// Pass 0 sizes the arena (size, counts, Bawana region); pass 1 marks existing cells; pass 2 adds
+// walls, stairs, poles and starts. Directive order in the file therefore does not matter: the Bawana
+// region is checked against the size once pass 0 has read both.
+static int parse_pass(Maze* m, const char* text, int pass, char* err, size_t errSize){
+    MazeLine l = { text, text, 0, err, errSize };
+    bool sized=false;
+    int bawana[7], bawanaLine=0;
+    for(const char* p=text; *p; ){
+        const char* eol=strchr(p,'\n'); if(!eol) eol=p+strlen(p);
+        const char* hash=memchr(p,'#',(size_t)(eol-p));
+        l.p=p; l.end=hash?hash:eol; l.line++;
+        p = *eol ? eol+1 : eol;
+        const char* w; size_t len; int v[7];
+        if(!next_word(&l,&w,&len)) continue;
+        if(word_is(w,len,"size")){
+            if(pass!=0) continue;
+            if(next_ints(&l,v,3)) return -1;
+            if(v[0]<1 || v[1]<1 || v[2]<1 || (uint64_t)v[0]*(uint64_t)v[1]*(uint64_t)v[2]>MAZE_MAX_CELLS) return parse_error(&l,"board size must be positive and at most %u cells",MAZE_MAX_CELLS);
+            m->floors=v[0]; m->width=v[1]; m->length=v[2]; m->cellCount=v[0]*v[1]*v[2];
+            sized=true;
+        } else if(word_is(w,len,"rect") || word_is(w,len,"hole")){
+            if(pass!=1) continue;
+            if(next_ints(&l,v,5) || check_cell(&l,m,v[0],v[1],v[2]) || check_cell(&l,m,v[0],v[3],v[4])) return -1;
+            mark_rect(m,v,w[0]=='r');
+        } else if(word_is(w,len,"row")){
+            if(pass!=1) continue;
+            const char* cells; size_t n;
+            if(next_ints(&l,v,2) || check_cell(&l,m,v[0],v[1],0)) return -1;
+            if(!next_word(&l,&cells,&n) || n>(size_t)m->length) return parse_error(&l,"row needs at most %d cells",m->length);
+            for(size_t y=0;y<n;++y){
+                if(cells[y]!='.' && cells[y]!='#') return parse_error(&l,"row cells must be '.' or '#'");
+                uint8_t* c=&m->cells[maze_cell_index(m,v[0],v[1],(int)y)];
+                *c = cells[y]=='.' ? (uint8_t)(*c|CELL_VALID) : (uint8_t)(*c&~CELL_VALID);
+            }
+        } else if(word_is(w,len,"wall")){
+            if(pass!=2) continue;
+            if(next_ints(&l,v,5) || check_cell(&l,m,v[0],v[1],v[2]) || check_cell(&l,m,v[0],v[3],v[4])) return -1;
+            if(v[1]!=v[3] && v[2]!=v[4]) return parse_error(&l,"wall lines must be horizontal or vertical");
+            add_wall_line(m,v[0],v[1],v[2],v[3],v[4]);
+        } else if(word_is(w,len,"stair")){
+            if(pass==0){ if(++m->stairCount>MAX_STAIRS) return parse_error(&l,"more than %d stairs",MAX_STAIRS); continue; }
+            if(pass!=2) continue;
+            if(next_ints(&l,v,6) || check_cell(&l,m,v[0],v[1],v[2]) || check_cell(&l,m,v[3],v[4],v[5])) return -1;
+            bool up=true, down=true;
+            if(next_word(&l,&w,&len)){
+                if(word_is(w,len,"up")) down=false;
+                else if(word_is(w,len,"down")) up=false;
+                else if(!word_is(w,len,"both")) return parse_error(&l,"stair direction must be both, up or down");
+            }
+            m->stairs[m->stairCount++] = (Stair){v[0],v[1],v[2],v[3],v[4],v[5],up&&down,up,down};
+        } else if(word_is(w,len,"pole")){
+            if(pass==0){ m->poleCount++; continue; }
+            if(pass!=2) continue;
+            if(next_ints(&l,v,4) || check_cell(&l,m,v[0],v[2],v[3]) || check_cell(&l,m,v[1],v[2],v[3])) return -1;
+            if(v[1]>=v[0]) return parse_error(&l,"poles go from a higher floor to a lower one");
+            m->poles[m->poleCount++] = (Pole){v[0],v[1],v[2],v[3]};
+        } else if(word_is(w,len,"bawana")){
+            if(pass!=0) continue;
+            if(next_ints(&l,bawana,7)) return -1;
+            bawanaLine=l.line;
+        } else if(word_is(w,len,"start")){
+            if(pass!=2) continue;
+            if(m->startCount==MAZE_MAX_STARTS) return parse_error(&l,"more than %d starts",MAZE_MAX_STARTS);
+            const char* d; size_t dl;
+            if(next_ints(&l,v,5) || check_cell(&l,m,v[0],v[3],v[4])) return -1;
+            if(!next_word(&l,&d,&dl) || dl!=1 || !strchr("NESW",d[0])) return parse_error(&l,"start direction must be N, E, S or W");
+            m->starts[m->startCount++] = (MazeStart){v[0],v[1],v[2],v[3],v[4],(int)(strchr("NESW",d[0])-"NESW")};
+        } else if(word_is(w,len,"effects")){
+            if(pass!=0) continue;
+            if(next_ints(&l,v,4)) return -1;
+            if(v[0]<0 || v[1]<0 || v[2]<0 || v[3]<0 || v[0]+v[1]+v[2]+v[3]>100) return parse_error(&l,"effect percentages must be >=0 and sum to at most 100");
+            memcpy(m->effectPercent,v,sizeof m->effectPercent);
+        } else {
+            return parse_error(&l,"unknown directive '%.*s'",(int)len,w);
+        }
+        if(pass!=0 && next_word(&l,&w,&len)) return parse_error(&l,"unexpected '%.*s'",(int)len,w);
+    }
+    if(pass==0 && !sized){ l.line=0; return parse_error(&l,"missing size directive"); }
+    if(bawanaLine){
+        const int* b=bawana;
+        l.line=bawanaLine;
+        if(check_cell(&l,m,b[0],b[1],b[2]) || check_cell(&l,m,b[0],b[3],b[4]) || check_cell(&l,m,b[0],b[5],b[6])) return -1;
+        if(b[1]>b[3] || b[2]>b[4]) return parse_error(&l,"bawana region needs xMin<=xMax and yMin<=yMax");
+        m->bawana=(BawanaRegion){b[0],b[1],b[3],b[2],b[4],b[5],b[6]};
+        m->bawanaArea=(b[3]-b[1]+1)*(b[4]-b[2]+1);
+    }
+    return 0;
+}
+
+int maze_parse(Maze* m, const char* text, char* err, size_t errSize){
+    m->defaultLayout=false;
+    m->stairCount=0; m->poleCount=0; m->teleportCellCount=0; m->startCount=0;
+    m->bawana=(BawanaRegion){-1,0,-1,0,-1,-1,-1}; m->bawanaArea=0; // no Bawana unless described
+    static const int defaultPercent[4]={25,35,25,10};
+    memcpy(m->effectPercent,defaultPercent,sizeof defaultPercent);
+    m->flagFloor=0; m->flagX=0; m->flagY=0;
+    if(parse_pass(m,text,0,err,errSize)!=0) return -1;
+    if(maze_alloc(m)!=0){ if(err && errSize) snprintf(err,errSize,"out of memory"); return -1; }
+    m->stairCount=0; m->poleCount=0; // refilled by pass 2
+    if(parse_pass(m,text,1,err,errSize)!=0 || parse_pass(m,text,2,err,errSize)!=0) return -1;
+    maze_build_teleport_table(m);
+    maze_build_step_table(m);
+    maze_build_reach_table(m);
+    maze_build_run_table(m);
+    // Whole-board checks
+    bool any=false;
+    for(int i=0;i<m->cellCount && !any;++i) any = (m->cells[i]&CELL_VALID)!=0;
+    const char* problem = !any ? "no cells exist" : m->startCount==0 ? "no start positions" : m->bawanaArea==0 ? "no bawana region" : NULL;
+    for(int i=0;i<m->startCount && !problem;++i)
+        if(!maze_cell_exists(m,m->starts[i].floor,m->starts[i].entryX,m->starts[i].entryY)) problem="a start's entry cell does not exist";
+    if(problem){ if(err && errSize) snprintf(err,errSize,"%s",problem); return -1; }
+    return 0;
+}
+
+int maze_load_file(Maze* m, const char* path, char* err, size_t errSize){
+    FILE* f=fopen(path,"rb");
+    if(!f){ if(err && errSize) snprintf(err,errSize,"cannot open %s",path); return -1; }
+    char* text=NULL; size_t len=0, cap=0, n;
+    char chunk[65536];
+    while((n=fread(chunk,1,sizeof chunk,f))>0){
+        if(len+n+1>cap){
+            size_t ncap = cap ? cap*2 : sizeof chunk;
+            while(ncap<len+n+1) ncap*=2;
+            char* grown=realloc(text,ncap);
+            if(!grown){ free(text); fclose(f); if(err && errSize) snprintf(err,errSize,"out of memory"); return -1; }
+            text=grown; cap=ncap;
+        }
+        memcpy(text+len,chunk,n); len+=n;
+    }
+    fclose(f);
+    if(!text){ if(err && errSize) snprintf(err,errSize,"%s is empty",path); return -1; }
+    text[len]=0;
+    int rc=maze_parse(m,text,err,errSize);
+    free(text);
+    return rc;
+}
+
+// ---- Per-seed content ----
+
+void maze_randomize(Maze* m, unsigned seed){
+    Rng rng; rng_seed(&rng,seed,RNG_STREAM_MAZE);
+    memset(m->effects,0,sizeof *m->effects*(size_t)m->cellCount);
+
+    // Exact quota distribution per Rule 10 (default 25% none, 35% consumables (1-4), 25% add (1-2), 10% add (3-5), rest multipliers (2 or 3))
+    uint32_t* cell = maze_scratch_reserve(&m->scratch,sizeof *cell*(size_t)(m->cellCount?m->cellCount:1));
+    if(!cell) return;
+    int total=0;
+    for(int i=0;i<m->cellCount;++i) if(m->cells[i]&CELL_VALID) cell[total++]=(uint32_t)i; // floor, x, y order
+    int endNone = (int)((long long)total*m->effectPercent[0]/100);
+    int endConsume = endNone + (int)((long long)total*m->effectPercent[1]/100);
+    int endAddSmall = endConsume + (int)((long long)total*m->effectPercent[2]/100);
+    int endAddLarge = endAddSmall + (int)((long long)total*m->effectPercent[3]/100); // multipliers take the rest
+    // Shuffle the packed cell indices, then one pass over the quota ranges in order
+    for(int i=total-1;i>0;--i){ unsigned r = rng_bounded(&rng,(uint32_t)(i+1)); uint32_t t=cell[i]; cell[i]=cell[r]; cell[r]=t; }
+    for(int idx=endNone;idx<total;++idx){
+        CellEffect e;
+        if(idx<endConsume) e=(CellEffect){CELL_EFFECT_CONSUME,(int8_t)(rng_bounded(&rng,4)+1)};
+        else if(idx<endAddSmall) e=(CellEffect){CELL_EFFECT_ADD,(int8_t)(rng_bounded(&rng,2)+1)};
+        else if(idx<endAddLarge) e=(CellEffect){CELL_EFFECT_ADD,(int8_t)(rng_bounded(&rng,3)+3)};
+        else e=(CellEffect){CELL_EFFECT_MULTIPLY,rng_bit(&rng)?2:3};
+        m->effects[cell[idx]]=e;
+    }
+
+    // Random flag on existing cell (ensure reachable floor: any floor since connectivity provided)
+    while(1){
+        int f = (int)rng_bounded(&rng,(uint32_t)m->floors);
+        int x = (int)rng_bounded(&rng,(uint32_t)m->width);
+        int y = (int)rng_bounded(&rng,(uint32_t)m->length);
+        if(maze_cell_exists(m,f,x,y)){ m->flagFloor=f; m->flagX=x; m->flagY=y; break; }
+    }
+}
+
+// Reinitializing a Maze that already holds the default layout only redraws the per-seed content
+void maze_init(Maze* m, unsigned seed){
+    if(!m->defaultLayout || !m->arena){
+        if(maze_parse(m,maze_default_description,NULL,0)!=0) return; // only fails when out of memory
+        m->defaultLayout=true;
+    }
+    maze_randomize(m,seed);
+}
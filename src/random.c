@@ -1,5 +1,52 @@
-#include <stdint.h>
-#include <time.h>
-#include "maze.h"
+#include "random.h"
 
-// Placeholder for extended RNG utilities if needed later
+static uint64_t splitmix64(uint64_t* x){
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z>>30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z>>27)) * 0x94D049BB133111EBull;
+    return z ^ (z>>31);
+}
+
+void rng_seed(Rng* r, uint64_t seed, uint64_t stream){
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+    uint64_t a = splitmix64(&x), b = splitmix64(&x);
+    r->s[0]=(uint32_t)a; r->s[1]=(uint32_t)(a>>32); r->s[2]=(uint32_t)b; r->s[3]=(uint32_t)(b>>32);
+    if(!(r->s[0]|r->s[1]|r->s[2]|r->s[3])) r->s[0]=1u;
+}
+
+static void rng_jump_by(Rng* r, const uint32_t poly[4]){
+    uint32_t t[4]={0,0,0,0};
+    for(int i=0;i<4;++i)
+        for(int b=0;b<32;++b){
+            if(poly[i] & (1u<<b)){ t[0]^=r->s[0]; t[1]^=r->s[1]; t[2]^=r->s[2]; t[3]^=r->s[3]; }
+            rng_next(r);
+        }
+    r->s[0]=t[0]; r->s[1]=t[1]; r->s[2]=t[2]; r->s[3]=t[3];
+}
+
+void rng_jump(Rng* r){
+    static const uint32_t JUMP[4] = { 0x8764000bu, 0xf542d2d3u, 0x6fa035c3u, 0x77f2db5bu };
+    rng_jump_by(r,JUMP);
+}
+
+void rng_long_jump(Rng* r){
+    static const uint32_t LONG_JUMP[4] = { 0xb523952eu, 0x0b6f099fu, 0xccf5a0efu, 0x1c580662u };
+    rng_jump_by(r,LONG_JUMP);
+}
+
+Rng rng_split(Rng* r){
+    Rng child=*r;
+    rng_jump(r);
+    return child;
+}
+
+void rng_fill_dice(Rng* r, uint8_t* out, size_t n){
+    // 6^12 < 2^32: one unbiased draw below 6^12 yields 12 faces
+    const uint32_t pow12 = 2176782336u;
+    size_t i=0;
+    while(i+12<=n){
+        uint32_t v = rng_bounded(r,pow12);
+        for(int k=0;k<12;++k){ out[i++]=(uint8_t)(v%6u+1u); v/=6u; }
+    }
+    while(i<n) out[i++]=(uint8_t)(rng_bounded(r,6)+1u);
+}
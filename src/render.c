@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+#include "render.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+    RENDER_ATTR_TEXT, RENDER_ATTR_PLAIN, RENDER_ATTR_CONSUME, RENDER_ATTR_ADD, RENDER_ATTR_MULTIPLY,
+    RENDER_ATTR_STAIR, RENDER_ATTR_POLE, RENDER_ATTR_BAWANA, RENDER_ATTR_ENTRANCE, RENDER_ATTR_FLAG, RENDER_ATTR_WALL,
+    RENDER_ATTR_PLAYER // RENDER_PLAYER_COLOURS entries follow
+};
+#define RENDER_PLAYER_COLOURS 6
+#define RENDER_UNDERLINE 0x80u
+
+static const char* const sgr[RENDER_ATTR_PLAYER+RENDER_PLAYER_COLOURS]={
+    "", "2", "31", "32", "33", "1;36", "1;34", "35", "1;35", "1;97;41", "37",
+    "1;30;43", "1;30;46", "1;30;42", "1;30;45", "1;30;47", "1;97;44" };
+
+#define RENDER_PLAYER_WIDTH 22 // "A F0 (10,24) N MP:100 "
+#define RENDER_MAX_STATUS 8    // status rows: the round line plus up to 7 rows of players
+
+static double now_seconds(void){ struct timespec ts; timespec_get(&ts,TIME_UTC); return (double)ts.tv_sec+(double)ts.tv_nsec*1e-9; }
+
+static char player_glyph(int i){ return i<26 ? (char)('A'+i) : i<52 ? (char)('a'+i-26) : '@'; }
+
+static RenderCell* at(const Renderer* r, RenderCell* grid, int row, int col){ return &grid[(size_t)row*(size_t)r->cols+(size_t)col]; }
+
+static void put_text(Renderer* r, int row, int col, const char* s){
+    for(; *s && col<r->cols; ++s, ++col) *at(r,r->back,row,col)=(RenderCell){(uint8_t)*s,RENDER_ATTR_TEXT};
+}
+
+// Screen position of a cell's glyph
+static int cell_row(const Renderer* r, const Maze* m, int f, int x){ return r->boardRow+f*(m->width+1)+1+x; }
+
+static void draw_board(Renderer* r, const Maze* m){
+    for(size_t i=0;i<(size_t)r->rows*(size_t)r->cols;++i) r->base[i]=(RenderCell){' ',RENDER_ATTR_TEXT};
+    for(int f=0;f<m->floors;++f){
+        char title[32]; snprintf(title,sizeof title,"Floor %d",f);
+        RenderCell* row=at(r,r->base,r->boardRow+f*(m->width+1),0);
+        for(int k=0;title[k] && k<r->cols;++k) row[k]=(RenderCell){(uint8_t)title[k],RENDER_ATTR_TEXT};
+        for(int x=0;x<m->width;++x) for(int y=0;y<m->length;++y){
+            int c=maze_cell_index(m,f,x,y);
+            uint8_t cell=m->cells[c];
+            if(!(cell&CELL_VALID)) continue;
+            RenderCell glyph={'.',RENDER_ATTR_PLAIN};
+            switch(m->effects[c].type){
+                case CELL_EFFECT_CONSUME: glyph=(RenderCell){'-',RENDER_ATTR_CONSUME}; break;
+                case CELL_EFFECT_ADD: glyph=(RenderCell){'+',RENDER_ATTR_ADD}; break;
+                case CELL_EFFECT_MULTIPLY: glyph=(RenderCell){(uint8_t)('0'+m->effects[c].value),RENDER_ATTR_MULTIPLY}; break;
+                default: break;
+            }
+            if(cell&CELL_BAWANA) glyph=(RenderCell){'B',RENDER_ATTR_BAWANA};
+            if(maze_is_bawana_entrance(m,f,x,y)) glyph=(RenderCell){'E',RENDER_ATTR_ENTRANCE};
+            const TeleportCell* tc = (cell&CELL_TELEPORT) ? maze_find_teleport(m,c) : NULL;
+            if(tc) glyph = m->teleportCodes[tc->first]>=TELEPORT_POLE_BASE ? (RenderCell){'P',RENDER_ATTR_POLE} : (RenderCell){'#',RENDER_ATTR_STAIR};
+            if(!(cell&CELL_OPEN_N<<DIR_S) && maze_cell_exists(m,f,x+1,y)) glyph.attr|=RENDER_UNDERLINE;
+            *at(r,r->base,cell_row(r,m,f,x),2*y)=glyph;
+            if(!(cell&CELL_OPEN_N<<DIR_E) && maze_cell_exists(m,f,x,y+1)) *at(r,r->base,cell_row(r,m,f,x),2*y+1)=(RenderCell){'|',RENDER_ATTR_WALL};
+        }
+    }
+}
+
+int render_init(Renderer* r, FILE* out, const Game* g, int fps, int tps){
+    const Maze* m=&g->board->maze;
+    memset(r,0,sizeof *r);
+    r->out=out;
+    r->cols = 2*m->length>80 ? 2*m->length : 80;
+    int perRow=r->cols/RENDER_PLAYER_WIDTH;
+    int playerRows=(g->playerCount+perRow-1)/perRow;
+    r->statusRows = 1+(playerRows<RENDER_MAX_STATUS-1 ? playerRows : RENDER_MAX_STATUS-1);
+    r->boardRow=r->statusRows+1;
+    r->rows=r->boardRow+m->floors*(m->width+1);
+    size_t n=(size_t)r->rows*(size_t)r->cols;
+    r->base=malloc(n*sizeof *r->base); r->back=malloc(n*sizeof *r->back);
+    r->front=calloc(n,sizeof *r->front); // glyph 0 never matches, so the first frame draws everything
+    r->cap=n*40+64; r->buf=malloc(r->cap); // worst case: a cursor move and an attribute change for every cell
+    if(!r->base || !r->back || !r->front || !r->buf){ render_free(r); return -1; }
+    r->minInterval = fps>0 ? 1.0/fps : 0;
+    r->turnInterval = tps>0 ? 1.0/tps : 0;
+    r->start=now_seconds();
+    draw_board(r,m);
+    return 0;
+}
+
+void render_free(Renderer* r){
+    if(r->frames && r->out){ fprintf(r->out,"\x1b[0m\x1b[%d;1H\x1b[?25h",r->rows+1); fflush(r->out); }
+    free(r->base); free(r->back); free(r->front); free(r->buf);
+    memset(r,0,sizeof *r);
+}
+
+static void compose(Renderer* r, const Game* g){
+    const Maze* m=&g->board->maze;
+    memcpy(r->back,r->base,(size_t)r->rows*(size_t)r->cols*sizeof *r->back);
+    char line[160];
+    snprintf(line,sizeof line,"Round %d  Flag F%d (%d,%d)  frames %llu  skipped %llu", g->roundNumber, g->flagFloor, g->flagX, g->flagY, r->frames+1, r->skipped);
+    put_text(r,0,0,line);
+    int perRow=r->cols/RENDER_PLAYER_WIDTH, shown=(r->statusRows-1)*perRow;
+    for(int i=0;i<g->playerCount && i<shown;++i){
+        const Player* p=&g->players[i];
+        if(p->inMaze) snprintf(line,sizeof line,"%c F%d (%d,%d) %c MP:%d", player_glyph(i), p->floor, p->x, p->y, "NESW"[p->dir], p->movementPoints);
+        else snprintf(line,sizeof line,"%c waiting MP:%d", player_glyph(i), p->movementPoints);
+        put_text(r,1+i/perRow,(i%perRow)*RENDER_PLAYER_WIDTH,line);
+    }
+    if(g->playerCount>shown){ snprintf(line,sizeof line," +%d more",g->playerCount-shown); put_text(r,r->statusRows-1,r->cols-(int)strlen(line),line); }
+    RenderCell* flag=at(r,r->back,cell_row(r,m,g->flagFloor,g->flagX),2*g->flagY);
+    *flag=(RenderCell){'F',(uint8_t)(RENDER_ATTR_FLAG|(flag->attr&RENDER_UNDERLINE))};
+    // Highest id last, so the lowest id on a shared cell stays visible
+    for(int i=g->playerCount-1;i>=0;--i){
+        const Player* p=&g->players[i];
+        if(!p->inMaze) continue;
+        RenderCell* c=at(r,r->back,cell_row(r,m,p->floor,p->x),2*p->y);
+        *c=(RenderCell){(uint8_t)player_glyph(i),(uint8_t)((RENDER_ATTR_PLAYER+i%RENDER_PLAYER_COLOURS)|(c->attr&RENDER_UNDERLINE))};
+    }
+}
+
+static void emit(Renderer* r, const char* s, size_t n){ memcpy(r->buf+r->len,s,n); r->len+=n; }
+
+bool render_frame(Renderer* r, const Game* g, bool force){
+    double t=now_seconds();
+    if(!force && r->frames && t-r->lastFrame<r->minInterval){ r->skipped++; return false; }
+    compose(r,g);
+    r->len=0;
+    char seq[32];
+    if(!r->frames) emit(r,"\x1b[?25l\x1b[2J",10);
+    int curRow=-1, curCol=-1, curAttr=-1;
+    for(int row=0;row<r->rows;++row) for(int col=0;col<r->cols;++col){
+        RenderCell* b=at(r,r->back,row,col);
+        RenderCell* f=at(r,r->front,row,col);
+        if(b->ch==f->ch && b->attr==f->attr) continue;
+        if(row!=curRow || col!=curCol) emit(r,seq,(size_t)snprintf(seq,sizeof seq,"\x1b[%d;%dH",row+1,col+1));
+        if(b->attr!=curAttr){
+            curAttr=b->attr;
+            emit(r,seq,(size_t)snprintf(seq,sizeof seq,"\x1b[0%s%s%sm", sgr[curAttr&0x7f][0]?";":"", sgr[curAttr&0x7f], (curAttr&RENDER_UNDERLINE)?";4":""));
+        }
+        r->buf[r->len++]=(char)b->ch;
+        *f=*b; curRow=row; curCol=col+1;
+    }
+    if(r->len){ fwrite(r->buf,1,r->len,r->out); fflush(r->out); }
+    r->frames++; r->lastFrame=t;
+    return true;
+}
+
+bool render_turn(Renderer* r, const Game* g){
+    r->turns++;
+    if(r->turnInterval>0){
+        double wait=r->start+(double)r->turns*r->turnInterval-now_seconds();
+        if(wait>0){
+            struct timespec ts={(time_t)wait,(long)((wait-(double)(time_t)wait)*1e9)};
+            nanosleep(&ts,NULL);
+        }
+    }
+    return render_frame(r,g,false);
+}
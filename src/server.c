@@ -0,0 +1,307 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include <stdio.h>
+
+#ifndef __linux__
+int server_run(const ServerOptions* opt){ (void)opt; fprintf(stderr,"server mode needs Linux (epoll)\n"); return -1; }
+#else
+#include "boardcache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVER_LINE_MAX 128          // longest command line
+#define SERVER_OUT_CAP (16*1024)     // per-session output buffer
+#define SERVER_OUT_ROOM 128          // a session only plays a turn or runs a command while its lines (T, R and E) still fit
+#define SERVER_LISTENER UINT32_MAX   // epoll tag of the listening socket
+#define SERVER_BOARD_CACHE 64
+
+typedef struct {
+    int fd;                 // -1 = free
+    uint32_t id;            // connection number, for the client's logs
+    Game game;
+    const Board* board;     // from the board cache, NULL = no game yet
+    GameWatch watch;
+    int nextPlayer;
+    bool over;
+    bool queued;            // in the run list
+    bool wantWrite;         // EPOLLOUT registered: the client is not keeping up
+    bool readPaused;        // EPOLLIN dropped: commands wait until the output buffer has room again
+    unsigned long long pending; // turns asked for and not played yet
+    char in[SERVER_LINE_MAX];
+    size_t inLen;
+    char* out;              // [SERVER_OUT_CAP]
+    size_t outLen, outSent;
+} ServerSession;
+
+typedef struct {
+    const ServerOptions* opt;
+    int epfd, listenFd;
+    ServerSession* session; // [opt->sessions]
+    int* freeList; int freeCount;
+    int* runList; int runCount; // sessions with turns pending
+    BoardCache boards;
+    unsigned long long accepted, turns, games;
+} Server;
+
+static volatile sig_atomic_t stopping;
+static void on_stop(int sig){ (void)sig; stopping=1; }
+
+static double mono_ms(void){ struct timespec ts; clock_gettime(CLOCK_MONOTONIC,&ts); return (double)ts.tv_sec*1e3+(double)ts.tv_nsec*1e-6; }
+
+static bool out_room(const ServerSession* s){ return SERVER_OUT_CAP-s->outLen>=SERVER_OUT_ROOM; }
+
+// Callers check out_room first, so a line is never cut short
+static void out_printf(ServerSession* s, const char* fmt, ...){
+    va_list ap; va_start(ap,fmt);
+    int n=vsnprintf(s->out+s->outLen,SERVER_OUT_CAP-s->outLen,fmt,ap);
+    va_end(ap);
+    if(n>0) s->outLen += (size_t)n<SERVER_OUT_CAP-s->outLen ? (size_t)n : SERVER_OUT_CAP-s->outLen-1;
+}
+
+static void watch_events(Server* sv, ServerSession* s, bool out, bool paused){
+    struct epoll_event ev={ .events=(paused?0u:EPOLLIN)|(out?EPOLLOUT:0u), .data.u32=(uint32_t)(s-sv->session) };
+    epoll_ctl(sv->epfd,EPOLL_CTL_MOD,s->fd,&ev);
+    s->wantWrite=out; s->readPaused=paused;
+}
+
+static void session_close(Server* sv, ServerSession* s){
+    epoll_ctl(sv->epfd,EPOLL_CTL_DEL,s->fd,NULL);
+    close(s->fd);
+    s->fd=-1;
+    if(s->board){ board_cache_release(&sv->boards,s->board); s->board=NULL; } // the Game keeps its player storage
+    s->pending=0; // dropped from the run list at the next tick
+    if(!s->queued) sv->freeList[sv->freeCount++]=(int)(s-sv->session);
+}
+
+// Sends what the socket takes; false when the client is gone
+static bool session_flush(Server* sv, ServerSession* s){
+    while(s->outSent<s->outLen){
+        ssize_t n=send(s->fd,s->out+s->outSent,s->outLen-s->outSent,MSG_NOSIGNAL|MSG_DONTWAIT);
+        if(n>0){ s->outSent+=(size_t)n; continue; }
+        if(n<0 && errno==EINTR) continue;
+        if(n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)){ if(!s->wantWrite) watch_events(sv,s,true,s->readPaused); return true; }
+        return false;
+    }
+    s->outLen=s->outSent=0;
+    if(s->wantWrite) watch_events(sv,s,false,s->readPaused);
+    return true;
+}
+
+static void session_end(Server* sv, ServerSession* s, int result){
+    s->over=true; s->pending=0; sv->games++;
+    out_printf(s,"E %d %d\n", result, s->game.roundNumber);
+}
+
+// The loop of game_play, cut at turn boundaries: a round starts with the cap and stall checks
+static void session_play(Server* sv, ServerSession* s, int turns){
+    Game* g=&s->game;
+    for(int t=0; t<turns && s->pending && !s->over && out_room(s); ++t){
+        if(s->nextPlayer==0){
+            int stop = g->roundNumber>=sv->opt->maxRounds ? GAME_RESULT_CAPPED : game_watch_check(&s->watch,g);
+            if(stop){ session_end(sv,s,stop); break; }
+        }
+        int pid=s->nextPlayer;
+        bool won=game_take_turn(g,(PlayerId)pid);
+        const Player* p=&g->players[pid];
+        s->pending--; sv->turns++;
+        out_printf(s,"T %d %d %d %d %d %d %d\n", g->roundNumber, pid, p->inMaze, p->floor, p->x, p->y, p->movementPoints);
+        if(won){ session_end(sv,s,pid); break; }
+        if(++s->nextPlayer==g->playerCount){
+            s->nextPlayer=0; g->roundNumber++; game_round_end(g);
+            out_printf(s,"R %d\n", g->roundNumber);
+        }
+    }
+}
+
+static void session_queue(Server* sv, ServerSession* s){
+    if(s->queued) return;
+    s->queued=true; sv->runList[sv->runCount++]=(int)(s-sv->session);
+}
+
+static void session_command(Server* sv, ServerSession* s, char* line){
+    char cmd[8]; unsigned long long a=0; int b=GAME_DEFAULT_PLAYERS;
+    int n=sscanf(line,"%7s %llu %d",cmd,&a,&b);
+    if(n<1) return; // blank line
+    if(strcmp(cmd,"NEW")==0 && n>=2){
+        if(b<1 || b>GAME_MAX_PLAYERS){ out_printf(s,"ERR players must be 1..%d\n", GAME_MAX_PLAYERS); return; }
+        const Board* board=board_cache_acquire(&sv->boards,(unsigned)a);
+        if(!board){ out_printf(s,"ERR out of memory\n"); return; }
+        if(s->board) board_cache_release(&sv->boards,s->board);
+        s->board=board;
+        game_init_from_board(&s->game,board,(unsigned)a); // keeps the storage reserved in server_run (or grown since)
+        game_set_sink(&s->game,NULL,NULL);
+        if(game_set_players(&s->game,b)!=0){
+            board_cache_release(&sv->boards,board); s->board=NULL;
+            out_printf(s,"ERR out of memory\n"); return;
+        }
+        game_watch_init(&s->watch,&s->game);
+        s->nextPlayer=0; s->over=false; s->pending=0;
+        out_printf(s,"OK %u\n", s->id);
+    }
+    else if(strcmp(cmd,"RUN")==0 && n>=2){
+        if(!s->board){ out_printf(s,"ERR no game\n"); return; }
+        if(s->over) return; // its E line is already out
+        s->pending+=a;
+        session_queue(sv,s);
+    }
+    else if(strcmp(cmd,"QUIT")==0) session_close(sv,s);
+    else out_printf(s,"ERR unknown command\n");
+}
+
+// Runs the complete command lines read so far while their replies fit; false when the session closed
+static bool session_commands(Server* sv, ServerSession* s){
+    char* start=s->in; char* nl;
+    while(out_room(s) && (nl=memchr(start,'\n',s->inLen-(size_t)(start-s->in)))!=NULL){
+        *nl=0; session_command(sv,s,start); start=nl+1;
+        if(s->fd<0) return false;
+    }
+    s->inLen-=(size_t)(start-s->in);
+    memmove(s->in,start,s->inLen);
+    if(s->inLen==sizeof s->in && out_room(s)){ out_printf(s,"ERR line too long\n"); session_flush(sv,s); session_close(sv,s); return false; }
+    return true;
+}
+
+// Reads and runs commands until the socket is drained or the output buffer is too full for another
+// reply; then reading pauses (EPOLLIN dropped) until session_resume finds room again
+static void session_read(Server* sv, ServerSession* s){
+    while(session_commands(sv,s) && out_room(s)){
+        ssize_t n=recv(s->fd,s->in+s->inLen,sizeof s->in-s->inLen,MSG_DONTWAIT);
+        if(n<0 && errno==EINTR) continue;
+        if(n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) break;
+        if(n<=0){ session_close(sv,s); return; }
+        s->inLen+=(size_t)n;
+    }
+    if(s->fd<0) return;
+    if(s->outLen && !session_flush(sv,s)){ session_close(sv,s); return; }
+    bool paused=!out_room(s);
+    if(paused!=s->readPaused) watch_events(sv,s,s->wantWrite,paused);
+}
+
+static void session_resume(Server* sv, ServerSession* s){
+    if(s->fd>=0 && s->readPaused && out_room(s)) session_read(sv,s);
+}
+
+static void server_accept(Server* sv){
+    for(;;){
+        int fd=accept4(sv->listenFd,NULL,NULL,SOCK_NONBLOCK|SOCK_CLOEXEC);
+        if(fd<0){ if(errno==EINTR) continue; return; }
+        if(!sv->freeCount){
+            static const char full[]="ERR server full\n";
+            if(send(fd,full,sizeof full-1,MSG_NOSIGNAL|MSG_DONTWAIT)<0){} // best effort
+            close(fd); continue;
+        }
+        int i=sv->freeList[--sv->freeCount];
+        ServerSession* s=&sv->session[i];
+        s->fd=fd; s->id=(uint32_t)sv->accepted++; s->board=NULL; s->over=false; s->pending=0;
+        s->wantWrite=false; s->readPaused=false; s->inLen=0; s->outLen=s->outSent=0;
+        struct epoll_event ev={ .events=EPOLLIN, .data.u32=(uint32_t)i };
+        if(epoll_ctl(sv->epfd,EPOLL_CTL_ADD,fd,&ev)!=0){ close(fd); s->fd=-1; sv->freeList[sv->freeCount++]=i; }
+    }
+}
+
+// One scheduling round: every queued session plays its share, then its output goes out
+static void server_tick(Server* sv){
+    int kept=0;
+    for(int k=0;k<sv->runCount;++k){
+        int i=sv->runList[k];
+        ServerSession* s=&sv->session[i];
+        if(s->fd>=0 && !s->wantWrite) session_play(sv,s,sv->opt->turnsPerTick);
+        if(s->fd>=0 && s->outLen>s->outSent && !session_flush(sv,s)) session_close(sv,s);
+        session_resume(sv,s);
+        if(s->fd>=0 && s->pending && !s->over){ sv->runList[kept++]=i; continue; }
+        s->queued=false;
+        if(s->fd<0) sv->freeList[sv->freeCount++]=i;
+    }
+    sv->runCount=kept;
+}
+
+static int listen_on(const char* path){
+    struct sockaddr_un addr; memset(&addr,0,sizeof addr);
+    addr.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof addr.sun_path){ errno=ENAMETOOLONG; return -1; }
+    strcpy(addr.sun_path,path);
+    int fd=socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(fd<0) return -1;
+    unlink(path); // a stale socket from an earlier run
+    if(bind(fd,(struct sockaddr*)&addr,sizeof addr)!=0 || listen(fd,SOMAXCONN)!=0){ close(fd); return -1; }
+    return fd;
+}
+
+static void server_free(Server* sv){
+    if(sv->session) for(int i=0;i<sv->opt->sessions;++i){
+        ServerSession* s=&sv->session[i];
+        if(s->fd>=0) close(s->fd);
+        if(s->board) board_cache_release(&sv->boards,s->board);
+        game_free(&s->game);
+        free(s->out);
+    }
+    if(sv->listenFd>=0){ close(sv->listenFd); unlink(sv->opt->socketPath); }
+    if(sv->epfd>=0) close(sv->epfd);
+    if(sv->boards.entry) board_cache_free(&sv->boards);
+    free(sv->session); free(sv->freeList); free(sv->runList);
+}
+
+int server_run(const ServerOptions* opt){
+    if(opt->sessions<1 || opt->turnsPerTick<1 || opt->tickMs<0 || opt->players<1 || opt->players>GAME_MAX_PLAYERS) return -1;
+    Server sv; memset(&sv,0,sizeof sv);
+    sv.opt=opt; sv.epfd=-1; sv.listenFd=-1;
+    // The whole pool up front: games (with player storage for opt->players), buffers and the lists
+    sv.session=calloc((size_t)opt->sessions,sizeof *sv.session);
+    sv.freeList=malloc(sizeof *sv.freeList*(size_t)opt->sessions);
+    sv.runList=malloc(sizeof *sv.runList*(size_t)opt->sessions);
+    if(sv.session) for(int i=0;i<opt->sessions;++i) sv.session[i].fd=-1; // before anything can fail: server_free closes fd>=0
+    bool ok = sv.session && sv.freeList && sv.runList && board_cache_init(&sv.boards,SERVER_BOARD_CACHE,opt->layout)==0;
+    for(int i=0; ok && i<opt->sessions; ++i){
+        ok = (sv.session[i].out=malloc(SERVER_OUT_CAP))!=NULL && game_reserve(&sv.session[i].game,opt->players)==0;
+        sv.freeList[opt->sessions-1-i]=i; // lowest index handed out first
+    }
+    sv.freeCount=opt->sessions;
+    if(!ok){ fprintf(stderr,"server: out of memory for %d sessions\n", opt->sessions); server_free(&sv); return -1; }
+    sv.listenFd=listen_on(opt->socketPath);
+    sv.epfd=epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event lev={ .events=EPOLLIN, .data.u32=SERVER_LISTENER };
+    if(sv.listenFd<0 || sv.epfd<0 || epoll_ctl(sv.epfd,EPOLL_CTL_ADD,sv.listenFd,&lev)!=0){
+        fprintf(stderr,"server: cannot listen on %s: %s\n", opt->socketPath, strerror(errno)); server_free(&sv); return -1;
+    }
+    struct sigaction sa; memset(&sa,0,sizeof sa);
+    sa.sa_handler=on_stop; sigemptyset(&sa.sa_mask); // no SA_RESTART: epoll_wait returns on the signal
+    sigaction(SIGINT,&sa,NULL); sigaction(SIGTERM,&sa,NULL);
+    fprintf(stderr,"[serving on %s: %d sessions, %d turns per tick every %d ms]\n", opt->socketPath, opt->sessions, opt->turnsPerTick, opt->tickMs);
+
+    enum { BATCH=256 };
+    struct epoll_event events[BATCH];
+    double nextTick=mono_ms();
+    while(!stopping){
+        int timeout=-1; // idle: sleep until a client speaks
+        if(sv.runCount){ double wait=nextTick-mono_ms(); timeout = wait>0 ? (int)wait+1 : 0; }
+        int n=epoll_wait(sv.epfd,events,BATCH,timeout);
+        if(n<0 && errno!=EINTR) break;
+        for(int k=0;k<n;++k){
+            uint32_t tag=events[k].data.u32;
+            if(tag==SERVER_LISTENER){ server_accept(&sv); continue; }
+            ServerSession* s=&sv.session[tag];
+            if(s->fd<0) continue; // closed earlier in this batch
+            if(events[k].events&(EPOLLERR|EPOLLHUP) && !(events[k].events&EPOLLIN)){ session_close(&sv,s); continue; }
+            if(events[k].events&EPOLLOUT && !session_flush(&sv,s)){ session_close(&sv,s); continue; }
+            if(events[k].events&EPOLLIN) session_read(&sv,s);
+            else session_resume(&sv,s);
+        }
+        double now=mono_ms();
+        if(sv.runCount && now>=nextTick){
+            server_tick(&sv);
+            nextTick = now+opt->tickMs;
+        }
+    }
+    fprintf(stderr,"[server stopped: %llu connections, %llu games finished, %llu turns]\n", sv.accepted, sv.games, sv.turns);
+    server_free(&sv);
+    return 0;
+}
+#endif
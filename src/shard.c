@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+#include "shard.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+int shard_run(const ShardOptions* opt, SweepStats* out){ (void)opt; (void)out; fprintf(stderr,"sharded sweeps need fork (POSIX)\n"); return -1; }
+#else
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#define SHARD_MAGIC "MZSHARD1"
+#define SHARD_VERSION 1
+
+// SweepStats with every field updated by atomic adds (min/max by compare-exchange)
+typedef struct {
+    atomic_ullong games, unfinished, unwinnable, stalled, totalRounds, finishedRounds;
+    atomic_ullong roundsSquared; // bits of a double
+    atomic_int players, minRounds, maxRounds;
+    atomic_ullong wins[GAME_MAX_PLAYERS];
+    atomic_ullong stepsMoved[GAME_MAX_PLAYERS], capturesDone[GAME_MAX_PLAYERS], timesCaptured[GAME_MAX_PLAYERS];
+    atomic_ullong stairsUsed[GAME_MAX_PLAYERS], polesUsed[GAME_MAX_PLAYERS], bawanaVisits[GAME_MAX_PLAYERS];
+} ShardTotals;
+
+// Lives in a shared anonymous mapping created before the fork. A worker commits a chunk by raising
+// writers, adding its stats, setting the chunk's bit, bumping commits and dropping writers; a save
+// copies the table and keeps the copy only when no commit was under way or finished meanwhile.
+typedef struct {
+    atomic_ullong nextChunk;
+    atomic_int stop;
+    atomic_ullong writers, commits, chunksDone;
+    ShardTotals totals;
+    atomic_ullong done[]; // bitmap of finished chunks
+} ShardTable;
+
+// Save file: header, then the bitmap words
+typedef struct {
+    char magic[8];
+    uint32_t version, players;
+    uint32_t fromSeed, toSeed, chunk;
+    int32_t maxRounds;
+    uint64_t layoutHash; // 0 = built-in board
+    uint64_t chunks, chunksDone;
+    SweepStats stats;
+} ShardFileHeader;
+
+static volatile sig_atomic_t stopping;
+static void on_stop(int sig){ (void)sig; stopping=1; }
+
+static double mono_seconds(void){ struct timespec ts; clock_gettime(CLOCK_MONOTONIC,&ts); return (double)ts.tv_sec+(double)ts.tv_nsec*1e-9; }
+
+static uint64_t layout_hash(const Maze* m){
+    if(!m) return 0;
+    uint64_t h=0xcbf29ce484222325ull;
+    const unsigned char* b=m->arena;
+    for(size_t i=0;i<m->arenaSize;++i) h=(h^b[i])*0x100000001b3ull;
+    for(int i=0;i<4;++i) h=game_hash_step(h,(uint32_t)m->effectPercent[i]);
+    return h ? h : 1;
+}
+
+static void atomic_min(atomic_int* a, int v){ int cur=atomic_load(a); while(v<cur && !atomic_compare_exchange_weak(a,&cur,v)){} }
+static void atomic_max(atomic_int* a, int v){ int cur=atomic_load(a); while(v>cur && !atomic_compare_exchange_weak(a,&cur,v)){} }
+
+static void totals_add(ShardTotals* t, const SweepStats* s){
+    atomic_fetch_add(&t->games,s->games); atomic_fetch_add(&t->unfinished,s->unfinished);
+    atomic_fetch_add(&t->unwinnable,s->unwinnable); atomic_fetch_add(&t->stalled,s->stalled);
+    atomic_fetch_add(&t->totalRounds,s->totalRounds); atomic_fetch_add(&t->finishedRounds,s->finishedRounds);
+    unsigned long long cur=atomic_load(&t->roundsSquared), next;
+    do { double d; memcpy(&d,&cur,sizeof d); d+=s->roundsSquared; memcpy(&next,&d,sizeof next); }
+    while(!atomic_compare_exchange_weak(&t->roundsSquared,&cur,next));
+    atomic_max(&t->players,s->players); atomic_min(&t->minRounds,s->minRounds); atomic_max(&t->maxRounds,s->maxRounds);
+    for(int i=0;i<s->players;++i){
+        atomic_fetch_add(&t->wins[i],s->wins[i]);
+        atomic_fetch_add(&t->stepsMoved[i],s->stepsMoved[i]); atomic_fetch_add(&t->capturesDone[i],s->capturesDone[i]);
+        atomic_fetch_add(&t->timesCaptured[i],s->timesCaptured[i]); atomic_fetch_add(&t->stairsUsed[i],s->stairsUsed[i]);
+        atomic_fetch_add(&t->polesUsed[i],s->polesUsed[i]); atomic_fetch_add(&t->bawanaVisits[i],s->bawanaVisits[i]);
+    }
+}
+
+static void totals_load(ShardTotals* t, SweepStats* s){
+    memset(s,0,sizeof *s);
+    s->games=atomic_load(&t->games); s->unfinished=atomic_load(&t->unfinished);
+    s->unwinnable=atomic_load(&t->unwinnable); s->stalled=atomic_load(&t->stalled);
+    s->totalRounds=atomic_load(&t->totalRounds); s->finishedRounds=atomic_load(&t->finishedRounds);
+    unsigned long long bits=atomic_load(&t->roundsSquared); memcpy(&s->roundsSquared,&bits,sizeof bits);
+    s->players=atomic_load(&t->players); s->minRounds=atomic_load(&t->minRounds); s->maxRounds=atomic_load(&t->maxRounds);
+    for(int i=0;i<s->players;++i){
+        s->wins[i]=atomic_load(&t->wins[i]);
+        s->stepsMoved[i]=atomic_load(&t->stepsMoved[i]); s->capturesDone[i]=atomic_load(&t->capturesDone[i]);
+        s->timesCaptured[i]=atomic_load(&t->timesCaptured[i]); s->stairsUsed[i]=atomic_load(&t->stairsUsed[i]);
+        s->polesUsed[i]=atomic_load(&t->polesUsed[i]); s->bawanaVisits[i]=atomic_load(&t->bawanaVisits[i]);
+    }
+}
+
+// Consistent copy of totals and bitmap; false when commits kept overlapping it
+static bool table_snapshot(ShardTable* t, size_t words, SweepStats* s, uint64_t* done, uint64_t* chunksDone){
+    for(int tries=0;tries<1000;++tries){
+        unsigned long long before=atomic_load(&t->commits);
+        if(atomic_load(&t->writers)){ usleep(100); continue; }
+        totals_load(&t->totals,s);
+        for(size_t w=0;w<words;++w) done[w]=atomic_load(&t->done[w]);
+        *chunksDone=atomic_load(&t->chunksDone);
+        if(!atomic_load(&t->writers) && atomic_load(&t->commits)==before) return true;
+    }
+    return false;
+}
+
+static int save_file(const ShardOptions* opt, const ShardFileHeader* h, const uint64_t* done, size_t words){
+    char tmp[4096];
+    if(snprintf(tmp,sizeof tmp,"%s.tmp",opt->savePath)>=(int)sizeof tmp) return -1;
+    FILE* f=fopen(tmp,"wb");
+    if(!f) return -1;
+    bool ok = fwrite(h,sizeof *h,1,f)==1 && fwrite(done,sizeof *done,words,f)==words && fflush(f)==0 && fsync(fileno(f))==0;
+    if(fclose(f)!=0) ok=false;
+    if(!ok || rename(tmp,opt->savePath)!=0){ remove(tmp); return -1; } // the previous save stays intact
+    return 0;
+}
+
+static bool save_progress(const ShardOptions* opt, ShardTable* t, ShardFileHeader* h, uint64_t* done, size_t words){
+    if(!opt->savePath) return true;
+    if(!table_snapshot(t,words,&h->stats,done,&h->chunksDone)){ fprintf(stderr,"[shard: no consistent snapshot, save skipped]\n"); return false; }
+    if(save_file(opt,h,done,words)!=0){ fprintf(stderr,"[shard: cannot write %s: %s]\n", opt->savePath, strerror(errno)); return false; }
+    return true;
+}
+
+// Restores a matching save into the fresh table; 0 also when there is no save yet
+static int load_progress(const ShardOptions* opt, const ShardFileHeader* expect, ShardTable* t, size_t words){
+    FILE* f=fopen(opt->savePath,"rb");
+    if(!f) return errno==ENOENT ? 0 : -1;
+    ShardFileHeader h;
+    uint64_t* done=malloc(sizeof *done*words);
+    int rc=-1;
+    if(done && fread(&h,sizeof h,1,f)==1 && fread(done,sizeof *done,words,f)==words){
+        if(memcmp(h.magic,expect->magic,sizeof h.magic)!=0 || h.version!=expect->version || h.players!=expect->players ||
+           h.fromSeed!=expect->fromSeed || h.toSeed!=expect->toSeed || h.chunk!=expect->chunk || h.maxRounds!=expect->maxRounds ||
+           h.layoutHash!=expect->layoutHash || h.chunks!=expect->chunks)
+            fprintf(stderr,"%s was saved by a different sweep (range, chunk, players, round cap or maze)\n", opt->savePath);
+        else {
+            totals_add(&t->totals,&h.stats);
+            for(size_t w=0;w<words;++w) atomic_store(&t->done[w],done[w]);
+            atomic_store(&t->chunksDone,h.chunksDone);
+            fprintf(stderr,"[shard: resuming %s, %llu of %llu chunks done]\n", opt->savePath, (unsigned long long)h.chunksDone, (unsigned long long)h.chunks);
+            rc=0;
+        }
+    } else fprintf(stderr,"%s is truncated or unreadable\n", opt->savePath);
+    free(done); fclose(f);
+    return rc;
+}
+
+static void shard_worker(const ShardOptions* opt, ShardTable* t, uint64_t chunks, unsigned chunk, pid_t coordinator){
+    signal(SIGINT,SIG_IGN); signal(SIGTERM,SIG_IGN); // the coordinator stops workers between chunks
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG,SIGKILL); // never outlive a killed coordinator
+    if(getppid()!=coordinator) _exit(1); // it died before the prctl
+#else
+    (void)coordinator;
+#endif
+    SweepOptions so = { 0, 0, 1, opt->maxRounds, NULL, opt->layout, opt->batch, opt->players, NULL, false, 0, 0, NULL };
+    while(!atomic_load(&t->stop)){
+        uint64_t c=atomic_fetch_add(&t->nextChunk,1ull);
+        if(c>=chunks) break;
+        if((atomic_load(&t->done[c>>6])>>(c&63))&1u) continue; // finished before the resume
+        so.fromSeed=opt->fromSeed+(unsigned)(c*chunk);
+        so.toSeed = (uint64_t)opt->toSeed-so.fromSeed<chunk ? opt->toSeed : so.fromSeed+chunk-1;
+        SweepStats s;
+        if(sweep_run(&so,&s)!=0) _exit(2);
+        atomic_fetch_add(&t->writers,1ull);
+        totals_add(&t->totals,&s);
+        atomic_fetch_or(&t->done[c>>6],1ull<<(c&63));
+        atomic_fetch_add(&t->chunksDone,1ull);
+        atomic_fetch_add(&t->commits,1ull);
+        atomic_fetch_sub(&t->writers,1ull);
+    }
+    _exit(0);
+}
+
+int shard_run(const ShardOptions* opt, SweepStats* out){
+    memset(out,0,sizeof *out); out->minRounds=INT_MAX;
+    if(opt->toSeed<opt->fromSeed || opt->players<1 || opt->players>GAME_MAX_PLAYERS) return -1;
+    unsigned chunk = opt->chunk ? opt->chunk : SHARD_DEFAULT_CHUNK;
+    uint64_t count=(uint64_t)(opt->toSeed-opt->fromSeed)+1, chunks=(count+chunk-1)/chunk;
+    size_t words=(size_t)((chunks+63)/64);
+    int procs = opt->procs>0 ? opt->procs : sweep_default_threads();
+    if((uint64_t)procs>chunks) procs=(int)chunks;
+    int saveSeconds = opt->saveSeconds>0 ? opt->saveSeconds : SHARD_DEFAULT_SAVE_SECONDS;
+
+    size_t tableSize=sizeof(ShardTable)+sizeof(atomic_ullong)*words;
+    ShardTable* t=mmap(NULL,tableSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0); // zero-filled
+    if(t==MAP_FAILED) return -1;
+    atomic_store(&t->totals.minRounds,INT_MAX);
+    ShardFileHeader h; memset(&h,0,sizeof h);
+    memcpy(h.magic,SHARD_MAGIC,sizeof h.magic); h.version=SHARD_VERSION; h.players=(uint32_t)opt->players;
+    h.fromSeed=opt->fromSeed; h.toSeed=opt->toSeed; h.chunk=chunk; h.maxRounds=opt->maxRounds;
+    h.layoutHash=layout_hash(opt->layout); h.chunks=chunks;
+    uint64_t* done=malloc(sizeof *done*words);
+    if(!done || (opt->savePath && load_progress(opt,&h,t,words)!=0)){ free(done); munmap(t,tableSize); return -1; }
+
+    struct sigaction sa, oldInt, oldTerm; memset(&sa,0,sizeof sa);
+    sa.sa_handler=on_stop; sigemptyset(&sa.sa_mask);
+    stopping=0;
+    sigaction(SIGINT,&sa,&oldInt); sigaction(SIGTERM,&sa,&oldTerm);
+    fflush(NULL); // nothing buffered gets written twice by the children
+    int live=0; bool failed=false;
+    pid_t self=getpid();
+    for(int k=0;k<procs;++k){
+        pid_t pid=fork();
+        if(pid==0) shard_worker(opt,t,chunks,chunk,self);
+        if(pid<0){ failed=true; atomic_store(&t->stop,1); break; }
+        live++;
+    }
+    double start=mono_seconds(), nextSave=start+saveSeconds;
+    unsigned long long startGames=atomic_load(&t->totals.games);
+    while(live){
+        int status;
+        pid_t pid=waitpid(-1,&status,WNOHANG);
+        if(pid>0){
+            live--;
+            if(!WIFEXITED(status) || WEXITSTATUS(status)!=0){ failed=true; atomic_store(&t->stop,1); }
+            continue;
+        }
+        if(pid<0 && errno!=EINTR) break;
+        if(stopping) atomic_store(&t->stop,1);
+        struct timespec nap={0,50*1000000L}; nanosleep(&nap,NULL);
+        double now=mono_seconds();
+        if(now>=nextSave){
+            save_progress(opt,t,&h,done,words);
+            unsigned long long games=atomic_load(&t->totals.games);
+            fprintf(stderr,"[shard: %llu of %llu chunks, %llu games, %.0f games/s]\n", (unsigned long long)atomic_load(&t->chunksDone),
+                (unsigned long long)chunks, games, (double)(games-startGames)/(now-start));
+            nextSave=now+saveSeconds;
+        }
+    }
+    sigaction(SIGINT,&oldInt,NULL); sigaction(SIGTERM,&oldTerm,NULL);
+    // Every worker is gone; a save still refuses a table a crashed worker left half-committed
+    bool saved=save_progress(opt,t,&h,done,words);
+    totals_load(&t->totals,out);
+    uint64_t finished=atomic_load(&t->chunksDone);
+    free(done); munmap(t,tableSize);
+    if(failed){ fprintf(stderr,"[shard: a worker failed; %s]\n", opt->savePath && saved ? "progress saved, rerun to resume" : "totals are incomplete"); return -1; }
+    if(finished<chunks){ fprintf(stderr,"[shard: stopped at %llu of %llu chunks%s]\n", (unsigned long long)finished, (unsigned long long)chunks, opt->savePath ? ", rerun to resume" : ""); return 1; }
+    return 0;
+}
+#endif
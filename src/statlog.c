@@ -0,0 +1,210 @@
+#include "statlog.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// seed is the game's (dice) seed in every table; a game's board seed only differs with sweep --boards
+enum { G_SEED, G_RESULT, G_ROUNDS, G_PLAYERS, G_STAIR_CYCLES, G_FLAG_FLOOR, G_FLAG_X, G_FLAG_Y, G_BOARD_SEED };
+static const StatLogColumn gameColumns[]={
+    {"seed",STAT_U32}, {"result",STAT_I32}, {"rounds",STAT_I32}, {"players",STAT_U16},
+    {"stair_cycles",STAT_U32}, {"flag_floor",STAT_U16}, {"flag_x",STAT_U16}, {"flag_y",STAT_U16}, {"board_seed",STAT_U32} };
+
+enum { P_SEED, P_PLAYER, P_WON, P_STEPS, P_CAPTURES, P_CAPTURED, P_STAIRS, P_POLES, P_BAWANA, P_MP, P_IN_MAZE };
+static const StatLogColumn playerColumns[]={
+    {"seed",STAT_U32}, {"player",STAT_U16}, {"won",STAT_U8}, {"steps",STAT_U32}, {"captures",STAT_U32}, {"captured",STAT_U32},
+    {"stairs",STAT_U32}, {"poles",STAT_U32}, {"bawana",STAT_U32}, {"mp",STAT_I32}, {"in_maze",STAT_U8} };
+
+enum { R_SEED, R_ROUND, R_PLAYER, R_IN_MAZE, R_FLOOR, R_X, R_Y, R_MP };
+static const StatLogColumn roundColumns[]={
+    {"seed",STAT_U32}, {"round",STAT_I32}, {"player",STAT_U16}, {"in_maze",STAT_U8},
+    {"floor",STAT_U16}, {"x",STAT_U16}, {"y",STAT_U16}, {"mp",STAT_I32} };
+
+static const struct { const char* name; const StatLogColumn* columns; int count; } tables[STATLOG_TABLES]={
+    { "games", gameColumns, (int)(sizeof gameColumns/sizeof *gameColumns) },
+    { "players", playerColumns, (int)(sizeof playerColumns/sizeof *playerColumns) },
+    { "rounds", roundColumns, (int)(sizeof roundColumns/sizeof *roundColumns) },
+};
+
+int statlog_type_width(StatType t){ return t==STAT_U8 ? 1 : t==STAT_U16 ? 2 : 4; }
+const char* statlog_table_name(StatTableId t){ return (unsigned)t<STATLOG_TABLES ? tables[t].name : "?"; }
+const StatLogColumn* statlog_table_columns(StatTableId t, int* count){ *count=tables[t].count; return tables[t].columns; }
+
+static size_t pad8(size_t n){ return (n+7)&~(size_t)7; }
+
+int statlog_file_open(StatLogFile* sf, const char* path){
+    sf->failed=false;
+    sf->f=fopen(path,"wb");
+    if(!sf->f) return -1;
+    StatLogHeader h; memset(&h,0,sizeof h);
+    memcpy(h.magic,STATLOG_MAGIC,8);
+    h.version=STATLOG_VERSION; h.tables=STATLOG_TABLES;
+    bool ok = fwrite(&h,sizeof h,1,sf->f)==1;
+    for(int t=0;t<STATLOG_TABLES && ok;++t){
+        StatLogTable d; memset(&d,0,sizeof d);
+        strncpy(d.name,tables[t].name,sizeof d.name-1);
+        d.columns=(uint32_t)tables[t].count;
+        ok = fwrite(&d,sizeof d,1,sf->f)==1 && fwrite(tables[t].columns,sizeof(StatLogColumn),(size_t)tables[t].count,sf->f)==(size_t)tables[t].count;
+    }
+    if(!ok){ fclose(sf->f); sf->f=NULL; return -1; }
+    pthread_mutex_init(&sf->mu,NULL);
+    return 0;
+}
+
+int statlog_file_close(StatLogFile* sf){
+    if(!sf->f) return -1;
+    if(fclose(sf->f)!=0) sf->failed=true;
+    sf->f=NULL;
+    pthread_mutex_destroy(&sf->mu);
+    return sf->failed ? -1 : 0;
+}
+
+int statlog_init(StatLog* log, StatLogFile* sf, bool rounds){
+    memset(log,0,sizeof *log);
+    log->file=sf;
+    for(int t=0;t<STATLOG_TABLES;++t){
+        if(t==STATLOG_ROUNDS && !rounds) continue;
+        // One allocation per table: group header followed by full-size columns, compacted before a short write
+        size_t bytes=sizeof(StatLogGroup);
+        for(int c=0;c<tables[t].count;++c) bytes+=(size_t)STATLOG_GROUP_ROWS*statlog_type_width(tables[t].columns[c].type);
+        if(!(log->group[t]=malloc(bytes))){ statlog_free(log); return -1; }
+        log->group[t]->table=(uint32_t)t; log->group[t]->rows=0;
+        uint8_t* p=(uint8_t*)(log->group[t]+1);
+        for(int c=0;c<tables[t].count;++c){ log->column[t][c]=p; p+=(size_t)STATLOG_GROUP_ROWS*statlog_type_width(tables[t].columns[c].type); }
+    }
+    return 0;
+}
+
+static int flush_table(StatLog* log, int t){
+    StatLogGroup* g=log->group[t];
+    if(!g || !g->rows) return 0;
+    uint8_t* dst=(uint8_t*)(g+1);
+    for(int c=0;c<tables[t].count;++c){
+        size_t used=(size_t)g->rows*statlog_type_width(tables[t].columns[c].type), padded=pad8(used);
+        if(dst!=log->column[t][c]) memmove(dst,log->column[t][c],used);
+        memset(dst+used,0,padded-used);
+        dst+=padded;
+    }
+    size_t bytes=(size_t)(dst-(uint8_t*)g);
+    pthread_mutex_lock(&log->file->mu);
+    bool ok = fwrite(g,1,bytes,log->file->f)==bytes;
+    if(!ok) log->file->failed=true;
+    pthread_mutex_unlock(&log->file->mu);
+    g->rows=0;
+    return ok ? 0 : -1;
+}
+
+int statlog_flush(StatLog* log){
+    int rc=0;
+    for(int t=0;t<STATLOG_TABLES;++t) if(flush_table(log,t)!=0) rc=-1;
+    return rc;
+}
+
+void statlog_free(StatLog* log){
+    if(log->file) statlog_flush(log);
+    for(int t=0;t<STATLOG_TABLES;++t){ free(log->group[t]); log->group[t]=NULL; }
+}
+
+static uint32_t row_begin(StatLog* log, int t){
+    if(log->group[t]->rows==STATLOG_GROUP_ROWS) flush_table(log,t);
+    return log->group[t]->rows++;
+}
+
+static void put(StatLog* log, int t, int c, uint32_t row, int64_t v){
+    uint8_t* col=log->column[t][c];
+    switch(tables[t].columns[c].type){
+        case STAT_U8: col[row]=(uint8_t)v; break;
+        case STAT_U16: ((uint16_t*)col)[row]=(uint16_t)v; break;
+        case STAT_U32: ((uint32_t*)col)[row]=(uint32_t)v; break;
+        case STAT_I32: ((int32_t*)col)[row]=(int32_t)v; break;
+    }
+}
+
+void statlog_add_game(StatLog* log, const Game* g, int winner){
+    unsigned seed=g->seed;
+    uint32_t r=row_begin(log,STATLOG_GAMES);
+    put(log,STATLOG_GAMES,G_SEED,r,seed); put(log,STATLOG_GAMES,G_RESULT,r,winner); put(log,STATLOG_GAMES,G_ROUNDS,r,g->roundNumber);
+    put(log,STATLOG_GAMES,G_PLAYERS,r,g->playerCount); put(log,STATLOG_GAMES,G_STAIR_CYCLES,r,g->totalStairCycles);
+    put(log,STATLOG_GAMES,G_FLAG_FLOOR,r,g->flagFloor); put(log,STATLOG_GAMES,G_FLAG_X,r,g->flagX); put(log,STATLOG_GAMES,G_FLAG_Y,r,g->flagY);
+    put(log,STATLOG_GAMES,G_BOARD_SEED,r,g->board->seed);
+    for(int i=0;i<g->playerCount;++i){
+        const Player* p=&g->players[i];
+        r=row_begin(log,STATLOG_PLAYERS);
+        put(log,STATLOG_PLAYERS,P_SEED,r,seed); put(log,STATLOG_PLAYERS,P_PLAYER,r,i); put(log,STATLOG_PLAYERS,P_WON,r,i==winner);
+        put(log,STATLOG_PLAYERS,P_STEPS,r,p->stepsMoved); put(log,STATLOG_PLAYERS,P_CAPTURES,r,p->capturesDone);
+        put(log,STATLOG_PLAYERS,P_CAPTURED,r,p->timesCaptured); put(log,STATLOG_PLAYERS,P_STAIRS,r,p->stairsUsed);
+        put(log,STATLOG_PLAYERS,P_POLES,r,p->polesUsed); put(log,STATLOG_PLAYERS,P_BAWANA,r,p->bawanaVisits);
+        put(log,STATLOG_PLAYERS,P_MP,r,p->movementPoints); put(log,STATLOG_PLAYERS,P_IN_MAZE,r,p->inMaze);
+    }
+}
+
+static void round_sink(const GameEvent* ev, void* user){
+    StatLog* log=user;
+    if(ev->type==GAME_EVENT_ROUND){
+        const Game* g=log->game;
+        for(int i=0;i<g->playerCount;++i){
+            const Player* p=&g->players[i];
+            uint32_t r=row_begin(log,STATLOG_ROUNDS);
+            put(log,STATLOG_ROUNDS,R_SEED,r,g->seed); put(log,STATLOG_ROUNDS,R_ROUND,r,ev->value); put(log,STATLOG_ROUNDS,R_PLAYER,r,i);
+            put(log,STATLOG_ROUNDS,R_IN_MAZE,r,p->inMaze); put(log,STATLOG_ROUNDS,R_FLOOR,r,p->floor);
+            put(log,STATLOG_ROUNDS,R_X,r,p->x); put(log,STATLOG_ROUNDS,R_Y,r,p->y); put(log,STATLOG_ROUNDS,R_MP,r,p->movementPoints);
+        }
+    }
+    if(log->next) log->next(ev,log->nextUser);
+}
+
+void statlog_attach(StatLog* log, Game* g){
+    if(!log->group[STATLOG_ROUNDS]) return;
+    log->game=g; log->next=g->sink; log->nextUser=g->sinkUser;
+    game_set_sink(g,round_sink,log);
+}
+
+int statlog_map(StatLogMap* m, const char* path){
+    memset(m,0,sizeof *m);
+    if(util_map_file(path,&m->base,&m->size)!=0) return -1;
+    const uint8_t* b=m->base;
+    const StatLogHeader* h=m->base;
+    size_t off=sizeof *h;
+    if(m->size<off || memcmp(h->magic,STATLOG_MAGIC,8)!=0 || h->version!=STATLOG_VERSION || h->tables>STATLOG_TABLES){ statlog_unmap(m); return -1; }
+    for(uint32_t t=0;t<h->tables;++t){
+        if(m->size-off<sizeof(StatLogTable)){ statlog_unmap(m); return -1; }
+        const StatLogTable* d=(const StatLogTable*)(b+off);
+        off+=sizeof *d;
+        if(d->columns>STATLOG_MAX_COLUMNS || (m->size-off)/sizeof(StatLogColumn)<d->columns){ statlog_unmap(m); return -1; }
+        m->columns[t]=(int)d->columns;
+        m->column[t]=(const StatLogColumn*)(b+off);
+        off+=d->columns*sizeof(StatLogColumn);
+    }
+    m->dataOffset=off;
+    return 0;
+}
+
+void statlog_unmap(StatLogMap* m){ if(m->base) util_unmap_file(m->base,m->size); m->base=NULL; m->size=0; }
+
+// A group cut short by the end of the file ends the walk
+bool statlog_next_group(const StatLogMap* m, size_t* offset, StatLogView* v){
+    const uint8_t* b=m->base;
+    if(m->size-*offset<sizeof(StatLogGroup)) return false;
+    const StatLogGroup* g=(const StatLogGroup*)(b+*offset);
+    if(g->table>=STATLOG_TABLES || !m->column[g->table]) return false;
+    size_t off=*offset+sizeof *g;
+    v->table=(StatTableId)g->table; v->rows=g->rows;
+    for(int c=0;c<m->columns[g->table];++c){
+        size_t bytes=pad8((size_t)g->rows*statlog_type_width((StatType)m->column[g->table][c].type));
+        if(m->size-off<bytes) return false;
+        v->column[c]=b+off;
+        off+=bytes;
+    }
+    *offset=off;
+    return true;
+}
+
+int64_t statlog_value(const StatLogMap* m, const StatLogView* v, int col, uint32_t row){
+    const uint8_t* p=v->column[col];
+    switch((StatType)m->column[v->table][col].type){
+        case STAT_U8: return p[row];
+        case STAT_U16: return ((const uint16_t*)p)[row];
+        case STAT_U32: return ((const uint32_t*)p)[row];
+        case STAT_I32: return ((const int32_t*)p)[row];
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "sweep.h"
+#include "eventlog.h"
+#include "statlog.h"
+#include "batch.h"
+#include "boardcache.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define SWEEP_CHUNK 256u // seeds handed to a worker at a time
+#define SWEEP_LOST_LIST 16u // lost seeds listed by sweep_run
+
+typedef struct {
+    const SweepOptions* opt;
+    atomic_ullong next; // offset of next unclaimed seed from opt->fromSeed
+    unsigned long long count;
+    EventLogFile* log; // NULL = no event log
+    StatLogFile* stats; // NULL = no stats file
+    BoardCache* boards; // NULL = every game generates its own board
+    atomic_int failedWorkers; // setup ran out of memory (or could not open its log streams)
+    atomic_ullong lost; // seeds claimed but not played (out of memory)
+    unsigned lostSeeds[SWEEP_LOST_LIST]; // the first of them; read after the workers are joined
+} SweepShared;
+
+typedef struct {
+    SweepShared* shared;
+    SweepStats stats;
+    uint32_t index;
+} SweepWorker;
+
+int sweep_default_threads(void){
+#ifdef _WIN32
+    SYSTEM_INFO si; GetSystemInfo(&si); return (int)si.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN); return n>0?(int)n:1;
+#endif
+}
+
+static void stats_clear(SweepStats* s){ memset(s,0,sizeof *s); s->minRounds=INT_MAX; s->maxRounds=0; }
+
+void sweep_stats_add_game(SweepStats* s, const Game* g, int winner){
+    s->games++;
+    if(g->playerCount > s->players) s->players=g->playerCount;
+    s->totalRounds += (unsigned long long)g->roundNumber;
+    s->roundsSquared += (double)g->roundNumber*(double)g->roundNumber;
+    if(winner>=0){
+        s->wins[winner]++;
+        s->finishedRounds += (unsigned long long)g->roundNumber;
+        if(g->roundNumber < s->minRounds) s->minRounds=g->roundNumber;
+        if(g->roundNumber > s->maxRounds) s->maxRounds=g->roundNumber;
+    } else {
+        s->unfinished++;
+        s->unwinnable += winner==GAME_RESULT_UNWINNABLE;
+        s->stalled += winner==GAME_RESULT_STALLED;
+    }
+    for(int i=0;i<g->playerCount;++i){
+        const Player* p=&g->players[i];
+        s->stepsMoved[i]+=p->stepsMoved; s->capturesDone[i]+=p->capturesDone; s->timesCaptured[i]+=p->timesCaptured;
+        s->stairsUsed[i]+=p->stairsUsed; s->polesUsed[i]+=p->polesUsed; s->bawanaVisits[i]+=p->bawanaVisits;
+    }
+}
+
+void sweep_stats_merge(SweepStats* dst, const SweepStats* src){
+    dst->games+=src->games; dst->unfinished+=src->unfinished; dst->unwinnable+=src->unwinnable; dst->stalled+=src->stalled;
+    dst->totalRounds+=src->totalRounds; dst->finishedRounds+=src->finishedRounds; dst->roundsSquared+=src->roundsSquared;
+    if(src->minRounds < dst->minRounds) dst->minRounds=src->minRounds;
+    if(src->maxRounds > dst->maxRounds) dst->maxRounds=src->maxRounds;
+    if(src->players > dst->players) dst->players=src->players;
+    for(int i=0;i<src->players;++i){
+        dst->wins[i]+=src->wins[i];
+        dst->stepsMoved[i]+=src->stepsMoved[i]; dst->capturesDone[i]+=src->capturesDone[i]; dst->timesCaptured[i]+=src->timesCaptured[i];
+        dst->stairsUsed[i]+=src->stairsUsed[i]; dst->polesUsed[i]+=src->polesUsed[i]; dst->bawanaVisits[i]+=src->bawanaVisits[i];
+    }
+}
+
+// Next seed of the worker's current chunk, claiming a new chunk when it runs out
+static bool claim_seed(SweepShared* sh, unsigned long long* next, unsigned long long* end, unsigned* seed){
+    if(*next>=*end){
+        unsigned long long begin = atomic_fetch_add(&sh->next, SWEEP_CHUNK);
+        if(begin>=sh->count) return false;
+        *next=begin; *end = begin+SWEEP_CHUNK<sh->count ? begin+SWEEP_CHUNK : sh->count;
+    }
+    *seed=(unsigned)(sh->opt->fromSeed+(*next)++);
+    return true;
+}
+
+// The Game keeps its player storage for the worker's next seed (game_free when the worker exits)
+static void sweep_game_done(SweepShared* sh, Game* g){
+    if(sh->boards) board_cache_release(sh->boards,g->board);
+}
+
+// Records a seed that was claimed but could not be played; always -1
+static int sweep_seed_lost(SweepShared* sh, unsigned seed){
+    unsigned long long k=atomic_fetch_add(&sh->lost,1ull);
+    if(k<SWEEP_LOST_LIST) sh->lostSeeds[k]=seed;
+    return -1;
+}
+
+// Fresh headless game for one seed, on a shared cached board when boards repeat and on the caller's
+// board storage otherwise; -1 (seed recorded as lost) when out of memory
+static int sweep_game_init(SweepShared* sh, Game* g, Board* board, unsigned seed){
+    const SweepOptions* opt=sh->opt;
+    if(sh->boards){
+        const Board* b=board_cache_acquire(sh->boards,opt->fromSeed+(seed-opt->fromSeed)%opt->boards);
+        if(!b) return sweep_seed_lost(sh,seed);
+        game_init_from_board(g,b,seed);
+    }
+    else if(!opt->layout) game_init(g,board,seed);
+    else if(board_init_from_layout(board,opt->layout,seed)!=0) return sweep_seed_lost(sh,seed);
+    else game_init_from_board(g,board,seed);
+    game_set_sink(g,NULL,NULL);
+    if(opt->config) game_set_config(g,*opt->config);
+    if(game_set_players(g,opt->players)!=0){ sweep_game_done(sh,g); return sweep_seed_lost(sh,seed); } // count checked by sweep_run
+    return 0;
+}
+
+// Lockstep variant: BATCH_LANES games in flight, each finished lane refilled with the next seed
+static void sweep_worker_batch(SweepWorker* w, StatLog* stats){
+    SweepShared* sh=w->shared;
+    GameBatch* batch = malloc(sizeof *batch);
+    Board* boards = util_aligned_calloc(BATCH_LANES,sizeof *boards,_Alignof(Board));
+    Game* games = calloc(BATCH_LANES,sizeof *games);
+    unsigned long long next=0, end=0;
+    unsigned seed;
+    if(batch && boards && games){
+        batch_init(batch);
+        uint32_t done=(1u<<BATCH_LANES)-1u; // every lane starts empty
+        do {
+            for(int l=0;l<BATCH_LANES;++l){
+                if(!((done>>l)&1u)) continue;
+                if((batch->active>>l)&1u){
+                    batch_lane_store(batch,l,&games[l]);
+                    sweep_stats_add_game(&w->stats,&games[l],batch->winner[l]);
+                    if(stats) statlog_add_game(stats,&games[l],batch->winner[l]);
+                    sweep_game_done(sh,&games[l]);
+                }
+                batch_lane_clear(batch,l);
+                while(claim_seed(sh,&next,&end,&seed))
+                    if(sweep_game_init(sh,&games[l],&boards[l],seed)==0){ batch_lane_load(batch,l,&games[l]); break; }
+            }
+        } while((done=batch_run(batch,sh->opt->maxRounds))!=0);
+    }
+    else atomic_fetch_add(&sh->failedWorkers,1);
+    if(boards) for(int l=0;l<BATCH_LANES;++l) board_free(&boards[l]);
+    if(games) for(int l=0;l<BATCH_LANES;++l) game_free(&games[l]);
+    free(batch); util_aligned_free(boards); free(games);
+}
+
+static void* sweep_worker(void* arg){
+    SweepWorker* w=arg;
+    SweepShared* sh=w->shared;
+    StatLog stats;
+    if(sh->stats && statlog_init(&stats,sh->stats,sh->opt->statsRounds)!=0){ atomic_fetch_add(&sh->failedWorkers,1); return NULL; }
+    if(sh->opt->batch && !sh->log && !sh->opt->statsRounds){
+        sweep_worker_batch(w,sh->stats?&stats:NULL);
+        if(sh->stats) statlog_free(&stats);
+        return NULL;
+    }
+    Board* board = util_aligned_calloc(1,sizeof *board,_Alignof(Board));
+    EventLog log;
+    if(!board || (sh->log && eventlog_init(&log,sh->log,w->index)!=0)){
+        atomic_fetch_add(&sh->failedWorkers,1);
+        util_aligned_free(board); if(sh->stats) statlog_free(&stats); return NULL;
+    }
+    Game g = {0};
+    unsigned long long next=0, end=0;
+    unsigned seed;
+    while(claim_seed(sh,&next,&end,&seed)){
+        if(sweep_game_init(sh,&g,board,seed)!=0) continue;
+        if(sh->log){ eventlog_begin_game(&log,g.seed,g.playerCount); eventlog_attach(&log,&g); }
+        if(sh->stats) statlog_attach(&stats,&g);
+        int winner = game_play(&g,sh->opt->maxRounds);
+        if(sh->log) eventlog_end_game(&log,&g,winner);
+        if(sh->stats) statlog_add_game(&stats,&g,winner);
+        sweep_stats_add_game(&w->stats,&g,winner);
+        sweep_game_done(sh,&g);
+    }
+    if(sh->log) eventlog_free(&log);
+    if(sh->stats) statlog_free(&stats);
+    game_free(&g);
+    board_free(board);
+    util_aligned_free(board);
+    return NULL;
+}
+
+int sweep_run(const SweepOptions* opt, SweepStats* out){
+    stats_clear(out);
+    if(opt->toSeed < opt->fromSeed || opt->players<1 || opt->players>GAME_MAX_PLAYERS) return -1;
+    int threads = opt->threads>0 ? opt->threads : sweep_default_threads();
+    SweepShared sh; sh.opt=opt; sh.count=(unsigned long long)(opt->toSeed-opt->fromSeed)+1ull; atomic_init(&sh.next,0ull);
+    atomic_init(&sh.failedWorkers,0); atomic_init(&sh.lost,0ull);
+    EventLogFile logFile; sh.log=NULL;
+    StatLogFile statFile; sh.stats=NULL;
+    BoardCache cache; sh.boards=NULL;
+    if(opt->eventLogPath){
+        if(eventlog_file_open(&logFile,opt->eventLogPath)!=0) return -1;
+        sh.log=&logFile;
+    }
+    if(opt->statsPath){
+        if(statlog_file_open(&statFile,opt->statsPath)!=0){ if(sh.log) eventlog_file_close(sh.log); return -1; }
+        sh.stats=&statFile;
+    }
+    if(opt->boards){
+        int capacity = opt->boardCache>0 ? opt->boardCache : SWEEP_BOARD_CACHE;
+        if((unsigned)capacity > opt->boards) capacity=(int)opt->boards;
+        if(board_cache_init(&cache,capacity,opt->layout)!=0){
+            if(sh.log) eventlog_file_close(sh.log);
+            if(sh.stats) statlog_file_close(sh.stats);
+            return -1;
+        }
+        sh.boards=&cache;
+    }
+    if((unsigned long long)threads > sh.count) threads=(int)sh.count;
+    SweepWorker* workers = calloc((size_t)threads,sizeof *workers);
+    pthread_t* tids = calloc((size_t)threads,sizeof *tids);
+    if(!workers || !tids){
+        free(workers); free(tids);
+        if(sh.log) eventlog_file_close(sh.log);
+        if(sh.stats) statlog_file_close(sh.stats);
+        if(sh.boards) board_cache_free(sh.boards);
+        return -1;
+    }
+    int started=0;
+    for(int t=0;t<threads;++t){
+        workers[t].shared=&sh; workers[t].index=(uint32_t)t; stats_clear(&workers[t].stats);
+        if(t>0 && pthread_create(&tids[t],NULL,sweep_worker,&workers[t])!=0) break;
+        started=t+1;
+    }
+    sweep_worker(&workers[0]); // calling thread is worker 0
+    for(int t=1;t<started;++t) pthread_join(tids[t],NULL);
+    for(int t=0;t<started;++t) sweep_stats_merge(out,&workers[t].stats);
+    free(workers); free(tids);
+    if(sh.boards) board_cache_free(sh.boards);
+    int rc=0;
+    // Workers that could not start leave their seeds to the others; seeds are missing only when none
+    // started or a game could not be set up
+    int failed=atomic_load(&sh.failedWorkers);
+    unsigned long long lost=atomic_load(&sh.lost);
+    if(failed) fprintf(stderr,"sweep: %d of %d workers could not start (out of memory)\n", failed, started);
+    if(out->games<sh.count){
+        fprintf(stderr,"sweep: %llu of %llu seeds not played", sh.count-out->games, sh.count);
+        if(lost){
+            fprintf(stderr,"; lost to out of memory:");
+            for(unsigned long long k=0;k<lost && k<SWEEP_LOST_LIST;++k) fprintf(stderr," %u", sh.lostSeeds[k]);
+            if(lost>SWEEP_LOST_LIST) fprintf(stderr," and %llu more", lost-SWEEP_LOST_LIST);
+        }
+        fprintf(stderr,"\n");
+        rc=-1;
+    }
+    if(sh.log && eventlog_file_close(sh.log)!=0) rc=-1;
+    if(sh.stats && statlog_file_close(sh.stats)!=0) rc=-1;
+    return rc;
+}
+
+void sweep_print(const SweepStats* s, FILE* out){
+    double n = s->games ? (double)s->games : 1.0;
+    unsigned long long finished = s->games - s->unfinished;
+    fprintf(out,"=== Sweep Summary ===\n");
+    fprintf(out,"Games: %llu  Finished: %llu  Unfinished: %llu (unwinnable %llu, stalled %llu, round cap %llu)\n", s->games, finished,
+        s->unfinished, s->unwinnable, s->stalled, s->unfinished-s->unwinnable-s->stalled);
+    if(finished) fprintf(out,"Rounds to win: avg %.2f  min %d  max %d\n", (double)s->finishedRounds/(double)finished, s->minRounds, s->maxRounds);
+    fprintf(out,"Rounds overall: avg %.2f\n", (double)s->totalRounds/n);
+    for(int i=0;i<s->players;++i){
+        fprintf(out,"P%d Wins:%llu (%.2f%%) Steps:%.2f Captures:%.3f Captured:%.3f Stairs:%.3f Poles:%.3f Bawana:%.3f\n", i,
+            s->wins[i], 100.0*(double)s->wins[i]/n, (double)s->stepsMoved[i]/n, (double)s->capturesDone[i]/n,
+            (double)s->timesCaptured[i]/n, (double)s->stairsUsed[i]/n, (double)s->polesUsed[i]/n, (double)s->bawanaVisits[i]/n);
+    }
+}
@@ -0,0 +1,171 @@
+#include "tune.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int tune_parse_list(const char* s, int* out, int cap){
+    int n=0;
+    while(*s){
+        char* end;
+        long v=strtol(s,&end,10);
+        if(end==s || n==cap) return -1;
+        out[n++]=(int)v;
+        if(*end==',') ++end;
+        else if(*end) return -1;
+        s=end;
+    }
+    return n;
+}
+
+int tune_parse_effects(const char* s, TuneGrid* g){
+    g->effectCount=0;
+    while(*s){
+        int* e=g->effects[g->effectCount];
+        int used=0;
+        if(g->effectCount==TUNE_MAX_VALUES || sscanf(s,"%d/%d/%d/%d%n",&e[0],&e[1],&e[2],&e[3],&used)!=4) return -1;
+        if(e[0]<0 || e[1]<0 || e[2]<0 || e[3]<0 || e[0]+e[1]+e[2]+e[3]>100) return -1;
+        g->effectCount++;
+        s+=used;
+        if(*s==',') ++s;
+        else if(*s) return -1;
+    }
+    return g->effectCount ? 0 : -1;
+}
+
+// Add-z^2/2 estimate of a share, so the interval of a share near 0 or 1 does not collapse
+static double share_half(double hits, double n, double z){
+    double p=(hits+z*z/2)/(n+z*z);
+    return z*sqrt(p*(1-p)/(n+z*z));
+}
+
+static void estimate(TuneResult* r, const TuneOptions* opt){
+    const SweepStats* s=&r->stats;
+    double n=(double)s->games, won=(double)(s->games-s->unfinished);
+    r->balance=0; r->balanceHalf = won>0 ? 0 : 1;
+    for(int i=0;i<opt->players && won>0;++i){
+        double d=fabs((double)s->wins[i]/won-1.0/opt->players), h=share_half((double)s->wins[i],won,opt->z);
+        if(d>r->balance) r->balance=d;
+        if(h>r->balanceHalf) r->balanceHalf=h;
+    }
+    r->rounds = n>0 ? (double)s->totalRounds/n : 0;
+    double var = n>1 ? (s->roundsSquared-n*r->rounds*r->rounds)/(n-1) : 0;
+    r->roundsHalf = n>1 ? opt->z*sqrt((var>0?var:0)/n) : r->rounds;
+    double lo=r->rounds-r->roundsHalf, hi=r->rounds+r->roundsHalf, t=opt->targetRounds;
+    if(t<=0){ r->lengthLo=lo; r->lengthHi=hi; }
+    else if(hi<t){ r->lengthLo=t-hi; r->lengthHi=t-lo; }
+    else if(lo>t){ r->lengthLo=lo-t; r->lengthHi=hi-t; }
+    else { r->lengthLo=0; r->lengthHi = t-lo>hi-t ? t-lo : hi-t; }
+}
+
+// b is better than a beyond the intervals on one objective and not worse beyond them on the other
+static bool dominates(const TuneResult* b, const TuneResult* a){
+    double bBalLo=b->balance-b->balanceHalf, bBalHi=b->balance+b->balanceHalf;
+    double aBalLo=a->balance-a->balanceHalf, aBalHi=a->balance+a->balanceHalf;
+    return (bBalHi<aBalLo && b->lengthLo<=a->lengthHi) || (b->lengthHi<a->lengthLo && bBalLo<=aBalHi);
+}
+
+static double length_objective(const TuneResult* r, double target){ return target>0 ? fabs(r->rounds-target) : r->rounds; }
+
+int tune_run(const TuneOptions* opt, const TuneGrid* grid, TuneReport* out){
+    memset(out,0,sizeof *out);
+    if(opt->batchGames<1 || opt->minGames<1 || opt->maxGames<opt->minGames || opt->z<=0 || opt->players<1 || opt->players>GAME_MAX_PLAYERS) return -1;
+    static const int defaultCycle[1]={5}, defaultOn[1]={1};
+    const int* cycle = grid->stairCycles ? grid->stairCycle : defaultCycle;
+    const int* oneWay = grid->oneWays ? grid->oneWay : defaultOn;
+    const int* alternate = grid->alternates ? grid->alternate : defaultOn;
+    int cycles = grid->stairCycles ? grid->stairCycles : 1, oneWays = grid->oneWays ? grid->oneWays : 1;
+    int alternates = grid->alternates ? grid->alternates : 1, rows = grid->effectCount ? grid->effectCount : 1;
+    // One layout per effect quota row, each a copy of the base layout (no rows: the base as it is)
+    Maze base; memset(&base,0,sizeof base);
+    Maze* layouts = calloc((size_t)rows,sizeof *layouts);
+    if(!layouts) return -1;
+    int rc = opt->layout ? maze_copy(&base,opt->layout) : maze_parse(&base,maze_default_description,NULL,0);
+    for(int e=0;e<rows && rc==0;++e){
+        rc=maze_copy(&layouts[e],&base);
+        if(grid->effectCount) memcpy(layouts[e].effectPercent,grid->effects[e],sizeof layouts[e].effectPercent);
+    }
+    maze_free(&base);
+    out->count = cycles*oneWays*alternates*rows;
+    out->targetRounds = opt->targetRounds;
+    out->result = rc==0 ? calloc((size_t)out->count,sizeof *out->result) : NULL;
+    int* layoutOf = malloc(sizeof *layoutOf*(size_t)out->count);
+    if(!out->result || !layoutOf){
+        for(int e=0;e<rows;++e) maze_free(&layouts[e]);
+        free(layouts); free(layoutOf); tune_report_free(out); return -1;
+    }
+    for(int i=0, e=0; e<rows; ++e)
+        for(int c=0;c<cycles;++c) for(int o=0;o<oneWays;++o) for(int a=0;a<alternates;++a,++i){
+            TuneResult* r=&out->result[i];
+            r->config=(GameConfig){ .stairCycleRounds=cycle[c], .forceOneWay=oneWay[o]!=0, .alternateDirections=alternate[a]!=0 };
+            memcpy(r->effectPercent,layouts[e].effectPercent,sizeof r->effectPercent);
+            r->state=TUNE_ACTIVE; r->dominatedBy=-1;
+            layoutOf[i]=e;
+        }
+    out->fixedGames=(unsigned long long)out->count*(unsigned long long)opt->maxGames;
+
+    for(int active=out->count, pass=1; active && rc==0; ++pass){
+        for(int i=0;i<out->count && rc==0;++i){
+            TuneResult* r=&out->result[i];
+            if(r->state!=TUNE_ACTIVE) continue;
+            unsigned long long left=(unsigned long long)opt->maxGames-r->stats.games;
+            unsigned from=opt->fromSeed+(unsigned)r->stats.games;
+            unsigned count=(unsigned)(left<(unsigned long long)opt->batchGames ? left : (unsigned long long)opt->batchGames);
+            SweepOptions so = { from, from+count-1, opt->threads, opt->maxRounds, NULL, &layouts[layoutOf[i]],
+                                false, opt->players, NULL, false, 0, 0, &r->config };
+            SweepStats batch;
+            if(sweep_run(&so,&batch)!=0){ rc=-1; break; }
+            if(r->stats.games) sweep_stats_merge(&r->stats,&batch); else r->stats=batch;
+            out->games+=batch.games;
+            estimate(r,opt);
+        }
+        // Stopping decisions use only configurations past minGames, compared as they stand after this pass
+        for(int i=0;i<out->count;++i){
+            TuneResult* r=&out->result[i];
+            if(r->state!=TUNE_ACTIVE || r->stats.games<(unsigned long long)opt->minGames) continue;
+            for(int j=0;j<out->count && r->dominatedBy<0;++j)
+                if(j!=i && out->result[j].stats.games>=(unsigned long long)opt->minGames && dominates(&out->result[j],r)) r->dominatedBy=j;
+            if(r->dominatedBy>=0) r->state=TUNE_DOMINATED;
+            else if(r->balanceHalf<=opt->balanceEps && r->roundsHalf<=opt->lengthEps*r->rounds) r->state=TUNE_TIGHT;
+            else if(r->stats.games>=(unsigned long long)opt->maxGames) r->state=TUNE_EXHAUSTED;
+            if(r->state!=TUNE_ACTIVE) active--;
+        }
+        fprintf(stderr,"[tune pass %d: %d of %d configurations still sampling, %llu games]\n", pass, active, out->count, out->games);
+    }
+    free(layoutOf);
+    for(int e=0;e<rows;++e) maze_free(&layouts[e]);
+    free(layouts);
+    return rc;
+}
+
+void tune_print(const TuneReport* r, FILE* out){
+    static const char* const state[]={"sampling","tight","dominated","max games"};
+    fprintf(out,"=== Tuning ===\n");
+    fprintf(out,"  # cycle oneway alt effects        games   balance          rounds              unfinished  stopped\n");
+    for(int i=0;i<r->count;++i){
+        const TuneResult* t=&r->result[i];
+        const int* e=t->effectPercent;
+        char eff[24]; snprintf(eff,sizeof eff,"%d/%d/%d/%d",e[0],e[1],e[2],e[3]);
+        fprintf(out,"%3d %5d %6d %3d %-13s %7llu   %.3f +-%.3f    %8.1f +-%-7.1f  %6.2f%%     %s", i, t->config.stairCycleRounds,
+            t->config.forceOneWay, t->config.alternateDirections, eff, t->stats.games, t->balance, t->balanceHalf, t->rounds, t->roundsHalf,
+            t->stats.games ? 100.0*(double)t->stats.unfinished/(double)t->stats.games : 0.0, state[t->state]);
+        if(t->dominatedBy>=0) fprintf(out," by #%d", t->dominatedBy);
+        fprintf(out,"\n");
+    }
+    // Front of the point estimates among the configurations nothing dominated
+    fprintf(out,"Pareto front (balance, length):");
+    for(int i=0;i<r->count;++i){
+        const TuneResult* a=&r->result[i];
+        if(a->state==TUNE_DOMINATED || !a->stats.games) continue;
+        bool front=true;
+        for(int j=0;j<r->count && front;++j){
+            const TuneResult* b=&r->result[j];
+            if(j==i || b->state==TUNE_DOMINATED || !b->stats.games) continue;
+            double la=length_objective(a,r->targetRounds), lb=length_objective(b,r->targetRounds);
+            if(b->balance<=a->balance && lb<=la && (b->balance<a->balance || lb<la)) front=false;
+        }
+        if(front) fprintf(out," #%d",i);
+    }
+    fprintf(out,"\nGames: %llu (a fixed sweep at the same cap: %llu, %.1f%%)\n", r->games, r->fixedGames, r->fixedGames ? 100.0*(double)r->games/(double)r->fixedGames : 0.0);
+}
+
+void tune_report_free(TuneReport* r){ free(r->result); memset(r,0,sizeof *r); }
@@ -1,2 +1,72 @@
+#define _POSIX_C_SOURCE 200809L
+#include "utils.h"
 #include <stdio.h>
-// Utility functions placeholder
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+int util_map_file(const char* path, void** base, size_t* size){
+    *base=NULL; *size=0;
+#ifdef _WIN32
+    // No mmap: read the file into a 64-byte aligned buffer
+    FILE* f=fopen(path,"rb");
+    if(!f) return -1;
+    if(fseek(f,0,SEEK_END)!=0){ fclose(f); return -1; }
+    long len=ftell(f); rewind(f);
+    void* p = len>0 ? _aligned_malloc((size_t)len,64) : NULL;
+    if(!p){ fclose(f); return -1; }
+    bool ok = fread(p,1,(size_t)len,f)==(size_t)len;
+    fclose(f);
+    if(!ok){ _aligned_free(p); return -1; }
+    *base=p; *size=(size_t)len;
+#else
+    int fd=open(path,O_RDONLY);
+    if(fd<0) return -1;
+    struct stat st;
+    if(fstat(fd,&st)!=0 || st.st_size<=0){ close(fd); return -1; }
+    void* p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(p==MAP_FAILED) return -1;
+    *base=p; *size=(size_t)st.st_size;
+#endif
+    return 0;
+}
+
+void* util_aligned_calloc(size_t count, size_t size, size_t align){
+    if(size && count>SIZE_MAX/size) return NULL;
+    size_t bytes=count*size;
+    bytes = bytes ? (bytes+align-1)/align*align : align; // aligned_alloc wants a multiple of the alignment
+#ifdef _WIN32
+    void* p=_aligned_malloc(bytes,align);
+#else
+    void* p=aligned_alloc(align,bytes);
+#endif
+    if(p) memset(p,0,bytes);
+    return p;
+}
+
+void util_aligned_free(void* p){
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void util_unmap_file(void* base, size_t size){
+    if(!base) return;
+#ifdef _WIN32
+    (void)size; _aligned_free(base);
+#else
+    munmap(base,size);
+#endif
+}
@@ -0,0 +1,122 @@
+// Flag reachability and capture odds of seeds, computed from the board instead of playing games
+// usage: maze_analyze <seed> [--maze <file>] [--players N] [--expected] [--horizon R] [fastflag]
+//        maze_analyze --scan <from> <to> [--maze <file>] [--players N] [--expected] [--horizon R]
+#include "analyze.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const Maze* layout; // NULL = built-in board
+    bool expected, fastflag;
+    int horizon, players;
+} Options;
+
+static char turns_char(int t){
+    if(t<0) return '-';
+    if(t<10) return (char)('0'+t);
+    if(t<36) return (char)('a'+t-10);
+    return '+';
+}
+
+static int setup(const Options* o, Board* b, Game* g, unsigned seed){
+    if(o->layout){ if(board_init_from_layout(b,o->layout,seed)!=0) return -1; }
+    else board_init(b,seed);
+    game_init_from_board(g,b,seed);
+    if(game_set_players(g,o->players)!=0) return -1;
+    game_set_sink(g,NULL,NULL);
+    if(o->fastflag){ g->flagFloor=0; g->flagX=5; g->flagY=12; } // same spot as maze_game's fastflag
+    return 0;
+}
+
+static void print_seed(const Game* g, const AnalyzeReachMap* r, const AnalyzeExpected* e){
+    const Maze* m=&g->board->maze;
+    printf("Seed %u: flag at F%d (%d,%d)%s\n", g->board->seed, g->flagFloor, g->flagX, g->flagY,
+           r->exactStairs ? "" : " [random stair toggling: all stair directions assumed open]");
+    printf("Fewest turns to the flag (every die in the player's favour):\n");
+    for(int i=0;i<g->playerCount;++i){
+        const MazeStart* s=&m->starts[i % m->startCount];
+        const AnalyzeReach* a=&r->start[i];
+        if(a->turns<0) printf("  P%d from F%d (%d,%d): unreachable\n", i, s->floor, s->x, s->y);
+        else printf("  P%d from F%d (%d,%d): %d turns, needs %lld MP (starts with %d)\n", i, s->floor, s->x, s->y, a->turns, a->mp, g->players[i].movementPoints);
+    }
+    printf("Per cell (0-9 a-z turns, + more, - unreachable, F flag, # no cell; rows are x, columns y):\n");
+    for(int f=0;f<m->floors;++f){
+        printf("Floor %d\n", f);
+        for(int x=0;x<m->width;++x){
+            char line[MAZE_MAX_DIM+1]; int n=0;
+            for(int y=0;y<m->length;++y){
+                int c=maze_cell_index(m,f,x,y);
+                line[n++] = !(m->cells[c]&CELL_VALID) ? '#' : (f==g->flagFloor && x==g->flagX && y==g->flagY) ? 'F' : turns_char(r->cellTurns[c]);
+            }
+            printf("  %.*s\n", n, line);
+        }
+    }
+    if(!e) return;
+    printf("Random dice over %d rounds (each player alone; game figures treat players as independent):\n", e->horizon);
+    for(int i=0;i<g->playerCount;++i){
+        const AnalyzeOdds* o=&e->player[i];
+        printf("  P%d: capture %.2f%%  stuck %.2f%%  expected rounds %.1f\n", i, 100*o->capture, 100*o->stuck, o->rounds);
+    }
+    printf("  Game: over %.2f%%  expected rounds %.1f\n", 100*e->gameOver, e->gameRounds);
+}
+
+// One line per seed; seeds where no player can reach the flag are marked UNREACHABLE
+static void print_scan_line(const Game* g, const AnalyzeReachMap* r, const AnalyzeExpected* e){
+    bool any=false;
+    printf("%u", g->board->seed);
+    for(int i=0;i<g->playerCount;++i){
+        if(r->start[i].turns<0) printf(" P%d:-", i); else { printf(" P%d:%d", i, r->start[i].turns); any=true; }
+    }
+    if(e) printf(" over:%.2f%% rounds:%.1f", 100*e->gameOver, e->gameRounds);
+    printf("%s\n", any ? "" : " UNREACHABLE");
+}
+
+static int analyze_seed(const Options* o, unsigned seed, bool scan){
+    static Board board;
+    Game g={0}; // game_free is safe on the error paths before setup reaches game_init_from_board
+    AnalyzeReachMap reach;
+    AnalyzeExpected expected;
+    if(setup(o,&board,&g,seed)!=0 || analyze_reach(&g,&reach)!=0 || (o->expected && analyze_expected(&g,o->horizon,&expected)!=0)){
+        fprintf(stderr,"out of memory\n"); game_free(&g); return -1;
+    }
+    if(scan) print_scan_line(&g,&reach,o->expected?&expected:NULL);
+    else print_seed(&g,&reach,o->expected?&expected:NULL);
+    analyze_reach_free(&reach);
+    game_free(&g);
+    return 0;
+}
+
+int main(int argc, char** argv){
+    bool scan = argc>1 && strcmp(argv[1],"--scan")==0;
+    if(argc<2 || (scan && argc<4)){
+        fprintf(stderr,"usage: %s <seed> [--maze <file>] [--players N] [--expected] [--horizon R] [fastflag]\n"
+                       "       %s --scan <from> <to> [--maze <file>] [--players N] [--expected] [--horizon R]\n", argv[0], argv[0]);
+        return 1;
+    }
+    static Maze layout;
+    Options o = { NULL, false, false, 200, GAME_DEFAULT_PLAYERS };
+    unsigned from=(unsigned)strtoul(argv[scan?2:1],NULL,10), to = scan ? (unsigned)strtoul(argv[3],NULL,10) : from;
+    for(int i=scan?4:2;i<argc;++i){
+        if(strcmp(argv[i],"--maze")==0 && i+1<argc){
+            char err[256];
+            if(maze_load_file(&layout,argv[++i],err,sizeof err)!=0){ fprintf(stderr,"cannot load maze %s: %s\n", argv[i], err); return 1; }
+            o.layout=&layout;
+        }
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc){
+            o.players=atoi(argv[++i]);
+            if(o.players<1 || o.players>GAME_MAX_PLAYERS){ fprintf(stderr,"--players must be 1..%d\n", GAME_MAX_PLAYERS); return 1; }
+        }
+        else if(strcmp(argv[i],"--expected")==0) o.expected=true;
+        else if(strcmp(argv[i],"--horizon")==0 && i+1<argc) o.horizon=atoi(argv[++i]);
+        else if(strcmp(argv[i],"fastflag")==0 && !scan) o.fastflag=true;
+        else { fprintf(stderr,"unknown option: %s\n", argv[i]); return 1; }
+    }
+    int rc=0;
+    for(unsigned s=from;;++s){
+        if(analyze_seed(&o,s,scan)!=0){ rc=1; break; }
+        if(s==to) break;
+    }
+    maze_free(&layout);
+    return rc;
+}
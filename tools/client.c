@@ -0,0 +1,125 @@
+// Load generator for maze_game --serve: many sessions over one poll loop, turns/sec, optional check
+// of every finished game against the same game played locally
+// usage: maze_client <socket> [--sessions N] [--seed S] [--players P] [--turns T] [--verify [--max-rounds R]]
+#define _GNU_SOURCE
+#include "game.h"
+#include <stdio.h>
+
+#ifndef __linux__
+int main(void){ fprintf(stderr,"maze_client needs Linux, like maze_game --serve\n"); return 1; }
+#else
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct {
+    int fd;
+    unsigned seed;
+    char in[4096];
+    size_t inLen;
+    unsigned long long turns;
+    int result, rounds;
+    bool done, ended; // ended: an E line came
+} ClientSession;
+
+static double mono_seconds(void){ struct timespec ts; clock_gettime(CLOCK_MONOTONIC,&ts); return (double)ts.tv_sec+(double)ts.tv_nsec*1e-9; }
+
+static int connect_to(const char* path){
+    struct sockaddr_un addr; memset(&addr,0,sizeof addr);
+    addr.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof addr.sun_path) return -1;
+    strcpy(addr.sun_path,path);
+    int fd=socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    if(fd<0) return -1;
+    if(connect(fd,(struct sockaddr*)&addr,sizeof addr)!=0){ close(fd); return -1; }
+    return fd;
+}
+
+static void handle_line(ClientSession* s, const char* line, unsigned long long want){
+    if(strncmp(line,"ERR",3)==0){ fprintf(stderr,"session %u: %s\n", s->seed, line); s->done=true; return; }
+    switch(line[0]){
+        case 'T': if(++s->turns>=want) s->done=true; break;
+        case 'E': sscanf(line,"E %d %d",&s->result,&s->rounds); s->done=s->ended=true; break;
+        case 'R': case 'O': break;
+        default: fprintf(stderr,"session %u: unexpected line %s\n", s->seed, line); s->done=true; break;
+    }
+}
+
+int main(int argc, char** argv){
+    if(argc<2){ fprintf(stderr,"usage: %s <socket> [--sessions N] [--seed S] [--players P] [--turns T] [--verify [--max-rounds R]]\n", argv[0]); return 1; }
+    int sessions=100, players=GAME_DEFAULT_PLAYERS, maxRounds=200000;
+    unsigned seed=1;
+    unsigned long long turns=1000000000ull; // effectively: until the game ends
+    bool verify=false;
+    for(int i=2;i<argc;++i){
+        if(strcmp(argv[i],"--sessions")==0 && i+1<argc) sessions=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--seed")==0 && i+1<argc) seed=(unsigned)strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--players")==0 && i+1<argc) players=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--turns")==0 && i+1<argc) turns=strtoull(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--verify")==0) verify=true;
+        else if(strcmp(argv[i],"--max-rounds")==0 && i+1<argc) maxRounds=atoi(argv[++i]);
+        else { fprintf(stderr,"unknown option: %s\n", argv[i]); return 1; }
+    }
+    if(sessions<1){ fprintf(stderr,"--sessions must be positive\n"); return 1; }
+    ClientSession* s=calloc((size_t)sessions,sizeof *s);
+    struct pollfd* pfd=calloc((size_t)sessions,sizeof *pfd);
+    if(!s || !pfd){ fprintf(stderr,"out of memory\n"); return 1; }
+    double t0=mono_seconds();
+    for(int i=0;i<sessions;++i){
+        s[i].seed=seed+(unsigned)i; s[i].result=GAME_RESULT_CAPPED;
+        if((s[i].fd=connect_to(argv[1]))<0){ fprintf(stderr,"cannot connect to %s: %s\n", argv[1], strerror(errno)); return 1; }
+        char cmd[64];
+        int n=snprintf(cmd,sizeof cmd,"NEW %u %d\nRUN %llu\n", s[i].seed, players, turns);
+        if(send(s[i].fd,cmd,(size_t)n,MSG_NOSIGNAL)!=n){ fprintf(stderr,"send failed\n"); return 1; }
+    }
+    int live=sessions;
+    while(live){
+        for(int i=0;i<sessions;++i) pfd[i]=(struct pollfd){ s[i].done ? -1 : s[i].fd, POLLIN, 0 };
+        if(poll(pfd,(nfds_t)sessions,-1)<0){ if(errno==EINTR) continue; perror("poll"); return 1; }
+        for(int i=0;i<sessions;++i){
+            ClientSession* c=&s[i];
+            if(c->done || !(pfd[i].revents&(POLLIN|POLLHUP|POLLERR))) continue;
+            ssize_t r=recv(c->fd,c->in+c->inLen,sizeof c->in-c->inLen,0);
+            if(r<=0){ fprintf(stderr,"session %u: connection lost\n", c->seed); c->done=true; live--; continue; }
+            c->inLen+=(size_t)r;
+            char* start=c->in; char* nl;
+            while(!c->done && (nl=memchr(start,'\n',c->inLen-(size_t)(start-c->in)))!=NULL){ *nl=0; handle_line(c,start,turns); start=nl+1; }
+            c->inLen-=(size_t)(start-c->in);
+            memmove(c->in,start,c->inLen);
+            if(c->done) live--;
+        }
+    }
+    double elapsed=mono_seconds()-t0;
+    unsigned long long total=0; int finished=0, mismatches=0;
+    static Board board;
+    static Game g;
+    for(int i=0;i<sessions;++i){
+        const char quit[]="QUIT\n";
+        if(send(s[i].fd,quit,sizeof quit-1,MSG_NOSIGNAL)<0){} // the server may have closed it already
+        close(s[i].fd);
+        total+=s[i].turns;
+        if(!s[i].ended) continue;
+        finished++;
+        if(!verify) continue;
+        game_init(&g,&board,s[i].seed);
+        game_set_sink(&g,NULL,NULL);
+        if(game_set_players(&g,players)!=0){ fprintf(stderr,"out of memory\n"); return 1; }
+        int result=game_play(&g,maxRounds);
+        game_free(&g);
+        if(result!=s[i].result || g.roundNumber!=s[i].rounds){
+            mismatches++;
+            fprintf(stderr,"seed %u: server %d after %d rounds, local %d after %d rounds\n", s[i].seed, s[i].result, s[i].rounds, result, g.roundNumber);
+        }
+    }
+    board_free(&board);
+    printf("%d sessions, %d games finished, %llu turns in %.3fs (%.0f turns/s)\n", sessions, finished, total, elapsed, elapsed>0 ? (double)total/elapsed : 0.0);
+    if(verify) printf("verified %d games: %d mismatches\n", finished, mismatches);
+    free(s); free(pfd);
+    return mismatches ? 1 : 0;
+}
+#endif
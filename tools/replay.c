@@ -0,0 +1,178 @@
+// Event log reader: lists the games in a log, or pretty-prints one of them from any round
+// usage: maze_replay <log> [--game K | --seed S] [--round N]
+#include "eventlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t stream;
+    unsigned seed;
+    EventLogCursor at; // positioned on the EVLOG_GAME_BEGIN record, following its stream
+    unsigned long long events;
+    int players;
+    int rounds, winner; // winner: PlayerId or GameResult
+    bool ended;
+} GameInfo;
+
+typedef struct {
+    GameInfo* items;
+    size_t count, cap;
+} GameList;
+
+// Player state folded from events; MP is exact except after a random-MP Bawana effect
+typedef struct {
+    bool inMaze;
+    int floor, x, y;
+    int mp;
+    bool mpKnown;
+} ReplayPlayer;
+
+// Winner or GameResult of an EVLOG_GAME_END record (logs from before early termination carry other = -1)
+static int end_result(const GameEvent* ev){ return ev->player>=0 ? ev->player : ev->other>0 ? -ev->other : GAME_RESULT_CAPPED; }
+
+// Scans the whole file once; games are numbered in order of their first record
+static int scan_games(const EventLogMap* map, GameList* list){
+    EventLogCursor c; eventlog_cursor_init(&c,map,EVLOG_ALL_STREAMS);
+    size_t* open=NULL; size_t openCap=0; // per stream: index+1 of the game in progress
+    const EventLogRecord* r;
+    for(;;){
+        EventLogCursor before=c;
+        if(!(r=eventlog_next(&c))) break;
+        uint32_t s=c.blockStream;
+        if(s>=openCap){
+            size_t n = s+1>openCap*2 ? s+1 : openCap*2;
+            size_t* grown=realloc(open,n*sizeof *open);
+            if(!grown){ free(open); return -1; }
+            memset(grown+openCap,0,(n-openCap)*sizeof *open);
+            open=grown; openCap=n;
+        }
+        if(r->type==EVLOG_GAME_BEGIN){
+            if(list->count==list->cap){
+                size_t n = list->cap ? list->cap*2 : 64;
+                GameInfo* grown=realloc(list->items,n*sizeof *grown);
+                if(!grown){ free(open); return -1; }
+                list->items=grown; list->cap=n;
+            }
+            GameEvent ev; eventlog_decode(r,&ev);
+            GameInfo* gi=&list->items[list->count++];
+            *gi=(GameInfo){ s, (unsigned)r->value, before, 0, ev.other>0 && ev.other<=GAME_MAX_PLAYERS ? ev.other : GAME_DEFAULT_PLAYERS, 0, -1, false };
+            gi->at.stream=s;
+            open[s]=list->count;
+            continue;
+        }
+        if(!open[s]) continue; // records before any game header
+        GameInfo* gi=&list->items[open[s]-1];
+        if(r->type==EVLOG_GAME_END){
+            GameEvent ev; eventlog_decode(r,&ev);
+            gi->rounds=ev.value; gi->winner=end_result(&ev); gi->ended=true; open[s]=0;
+        } else {
+            gi->events++;
+            if(r->type==GAME_EVENT_ROUND) gi->rounds=r->value;
+        }
+    }
+    free(open);
+    return 0;
+}
+
+static void fold(ReplayPlayer* ps, int players, const GameEvent* ev){
+    ReplayPlayer* p = (ev->player>=0 && ev->player<players) ? &ps[ev->player] : NULL;
+    if(!p && ev->type!=GAME_EVENT_CAPTURE) return; // no such player: a corrupt or mismatched log
+    switch(ev->type){
+        case GAME_EVENT_ENTER: p->inMaze=true; p->floor=ev->floor; p->x=ev->x; p->y=ev->y; break;
+        case GAME_EVENT_STEP: case GAME_EVENT_BLOCKED:
+            p->floor=ev->floor; p->x=ev->x; p->y=ev->y; p->mp=ev->value; p->mpKnown=true; break;
+        case GAME_EVENT_STAIR: case GAME_EVENT_POLE: p->floor=ev->floor; p->x=ev->x; p->y=ev->y; break;
+        case GAME_EVENT_BAWANA:
+            p->floor=ev->floor; p->x=ev->x; p->y=ev->y; // already the entrance for non-poison effects
+            if(ev->value==1 || ev->value==2) p->mp+=50;
+            else if(ev->value==3) p->mp+=200;
+            else if(ev->value==4) p->mpKnown=false;
+            break;
+        case GAME_EVENT_CAPTURE: if(ev->other>=0 && ev->other<players) ps[ev->other].inMaze=false; break;
+        default: break;
+    }
+}
+
+static void print_state(const ReplayPlayer* ps, int players, int round){
+    printf("State at round %d:\n", round);
+    for(int i=0;i<players;++i){
+        const ReplayPlayer* p=&ps[i];
+        if(!p->inMaze){ printf("P%d START\n", i); continue; }
+        if(p->mpKnown) printf("P%d F%d (%d,%d) MP:%d\n", i,p->floor,p->x,p->y,p->mp);
+        else printf("P%d F%d (%d,%d) MP:?\n", i,p->floor,p->x,p->y);
+    }
+}
+
+static void print_event(const GameEvent* ev){
+    switch(ev->type){
+        case GAME_EVENT_STEP: printf("P%d -> F%d (%d,%d) MP:%d\n", ev->player,ev->floor,ev->x,ev->y,ev->value); break;
+        case GAME_EVENT_BLOCKED: printf("P%d blocked at F%d (%d,%d) MP:%d\n", ev->player,ev->floor,ev->x,ev->y,ev->value); break;
+        case GAME_EVENT_STAIR: printf("P%d takes stair %d %s -> F%d (%d,%d)\n", ev->player,ev->value,ev->other?"up":"down",ev->floor,ev->x,ev->y); break;
+        case GAME_EVENT_POLE: printf("P%d slides down pole %d -> F%d (%d,%d)\n", ev->player,ev->value,ev->floor,ev->x,ev->y); break;
+        case GAME_EVENT_ROUND: printf("== Round %d ==\n", ev->value); break;
+        default: game_print_event(ev,NULL); break; // same text as the live console
+    }
+}
+
+static void replay_game(const GameInfo* gi, int fromRound){
+    printf("Game seed %u (stream %u, %d players)\n", gi->seed, gi->stream, gi->players);
+    ReplayPlayer ps[GAME_MAX_PLAYERS];
+    for(int i=0;i<gi->players;++i) ps[i]=(ReplayPlayer){ false,0,0,0,100,true };
+    EventLogCursor c=gi->at;
+    eventlog_next(&c); // the BEGIN record
+    int round=0;
+    bool printing = fromRound<=0;
+    const EventLogRecord* r;
+    while((r=eventlog_next(&c)) && r->type!=EVLOG_GAME_BEGIN){
+        GameEvent ev; eventlog_decode(r,&ev);
+        if(r->type==EVLOG_GAME_END){
+            if(!printing) print_state(ps,gi->players,round);
+            if(ev.player>=0) printf("Winner: Player %d after %d rounds\n", ev.player, ev.value);
+            else printf("No winner after %d rounds (%s)\n", ev.value, game_result_text(end_result(&ev)));
+            return;
+        }
+        if(ev.type==GAME_EVENT_ROUND){
+            round=ev.value;
+            if(!printing && round>=fromRound){ printing=true; print_state(ps,gi->players,round); }
+        }
+        fold(ps,gi->players,&ev);
+        if(printing) print_event(&ev);
+    }
+    if(!printing) print_state(ps,gi->players,round);
+    printf("[log ends at round %d without a game end record]\n", round);
+}
+
+int main(int argc, char** argv){
+    if(argc<2){ fprintf(stderr,"usage: %s <log> [--game K | --seed S] [--round N]\n", argv[0]); return 1; }
+    long gameIndex=-1; long long seed=-1; int fromRound=0;
+    for(int i=2;i<argc;++i){
+        if(strcmp(argv[i],"--game")==0 && i+1<argc) gameIndex=atol(argv[++i]);
+        else if(strcmp(argv[i],"--seed")==0 && i+1<argc) seed=(long long)strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--round")==0 && i+1<argc) fromRound=atoi(argv[++i]);
+        else { fprintf(stderr,"unknown option: %s\n", argv[i]); return 1; }
+    }
+    EventLogMap map;
+    if(eventlog_map(&map,argv[1])!=0){ fprintf(stderr,"cannot read event log %s\n", argv[1]); return 1; }
+    GameList list={0};
+    if(scan_games(&map,&list)!=0){ fprintf(stderr,"out of memory\n"); eventlog_unmap(&map); return 1; }
+    int rc=0;
+    if(gameIndex<0 && seed<0){
+        printf("%zu games in %s\n", list.count, argv[1]);
+        for(size_t k=0;k<list.count;++k){
+            const GameInfo* gi=&list.items[k];
+            printf("#%zu seed %u stream %u players %d rounds %d events %llu%s", k, gi->seed, gi->stream, gi->players, gi->rounds, gi->events, gi->ended?"":" (truncated)");
+            if(gi->winner>=0) printf(" winner P%d\n", gi->winner);
+            else if(gi->ended) printf(" no winner (%s)\n", game_result_text(gi->winner)); else printf(" no winner\n");
+        }
+    } else {
+        const GameInfo* pick=NULL;
+        for(size_t k=0;k<list.count && !pick;++k)
+            if((gameIndex>=0 && (size_t)gameIndex==k) || (seed>=0 && list.items[k].seed==(unsigned)seed)) pick=&list.items[k];
+        if(pick) replay_game(pick,fromRound);
+        else { fprintf(stderr,"game not found in %s\n", argv[1]); rc=1; }
+    }
+    free(list.items);
+    eventlog_unmap(&map);
+    return rc;
+}
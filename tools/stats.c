@@ -0,0 +1,67 @@
+// Columnar stats reader: row counts and per-column min/mean/max, or one table as CSV
+// usage: maze_stats <file> [--table games|players|rounds]
+#include "statlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    unsigned long long rows, groups;
+    int64_t min[STATLOG_MAX_COLUMNS], max[STATLOG_MAX_COLUMNS];
+    double sum[STATLOG_MAX_COLUMNS];
+} TableSummary;
+
+static void summarize(const StatLogMap* m){
+    TableSummary s[STATLOG_TABLES];
+    memset(s,0,sizeof s);
+    StatLogView v;
+    for(size_t off=m->dataOffset; statlog_next_group(m,&off,&v); ){
+        TableSummary* t=&s[v.table];
+        for(int c=0;c<m->columns[v.table];++c) for(uint32_t r=0;r<v.rows;++r){
+            int64_t x=statlog_value(m,&v,c,r);
+            if((t->rows==0 && r==0) || x<t->min[c]) t->min[c]=x;
+            if((t->rows==0 && r==0) || x>t->max[c]) t->max[c]=x;
+            t->sum[c]+=(double)x;
+        }
+        t->rows+=v.rows; t->groups++;
+    }
+    for(int t=0;t<STATLOG_TABLES;++t){
+        if(!m->column[t]) continue;
+        printf("%s: %llu rows in %llu groups\n", statlog_table_name((StatTableId)t), s[t].rows, s[t].groups);
+        if(!s[t].rows) continue;
+        for(int c=0;c<m->columns[t];++c)
+            printf("  %-14s min %-12lld mean %-14.3f max %lld\n", m->column[t][c].name, (long long)s[t].min[c], s[t].sum[c]/(double)s[t].rows, (long long)s[t].max[c]);
+    }
+}
+
+static void print_csv(const StatLogMap* m, StatTableId table){
+    for(int c=0;c<m->columns[table];++c) printf("%s%s", c?",":"", m->column[table][c].name);
+    printf("\n");
+    StatLogView v;
+    for(size_t off=m->dataOffset; statlog_next_group(m,&off,&v); ){
+        if(v.table!=table) continue;
+        for(uint32_t r=0;r<v.rows;++r){
+            for(int c=0;c<m->columns[table];++c) printf("%s%lld", c?",":"", (long long)statlog_value(m,&v,c,r));
+            printf("\n");
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    if(argc<2){ fprintf(stderr,"usage: %s <file> [--table games|players|rounds]\n", argv[0]); return 1; }
+    int table=-1;
+    for(int i=2;i<argc;++i){
+        if(strcmp(argv[i],"--table")==0 && i+1<argc){
+            ++i;
+            for(int t=0;t<STATLOG_TABLES;++t) if(strcmp(argv[i],statlog_table_name((StatTableId)t))==0) table=t;
+            if(table<0){ fprintf(stderr,"unknown table: %s\n", argv[i]); return 1; }
+        }
+        else { fprintf(stderr,"unknown option: %s\n", argv[i]); return 1; }
+    }
+    StatLogMap map;
+    if(statlog_map(&map,argv[1])!=0){ fprintf(stderr,"cannot read stats file %s\n", argv[1]); return 1; }
+    if(table<0) summarize(&map);
+    else if(map.column[table]) print_csv(&map,(StatTableId)table);
+    statlog_unmap(&map);
+    return 0;
+}